@@ -0,0 +1,380 @@
+#include "CompressedTables.hpp"
+#include "Parser.hpp"
+#include "TableProfile.hpp"
+#include <algorithm>
+#include <map>
+
+namespace {
+
+constexpr TokenID SymbolIndex_maxDenseSpan = 4096;
+
+int32_t encodeAction(const Action& action) {
+    return (int32_t)((action.value << 2) | action.type) + 1;
+}
+
+Action decodeAction(int32_t entry) {
+    if (entry == 0) {
+        return {};
+    }
+
+    --entry;
+    return { (ParserActType_)(entry & 3), (ParserState)(entry >> 2) };
+}
+
+using SparseRow = std::vector<std::pair<int32_t, int32_t>>;
+
+// Overlays the rows by displacement: each row gets the first base at which
+// none of its slots is taken, and the check array records the owning row.
+// Hotter rows go first, so they end up close together at the front.
+void packRows(const std::vector<SparseRow>& rows, const std::vector<uint64_t>& heat, std::vector<int32_t>& base, std::vector<int32_t>& next, std::vector<int32_t>& check) {
+    std::vector<uint32_t> order(rows.size());
+    for (uint32_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        if (heat[a] != heat[b]) {
+            return heat[a] > heat[b];
+        }
+        return rows[a].size() > rows[b].size();
+    });
+
+    base.assign(rows.size(), 0);
+    size_t firstFree = 0;
+
+    for (uint32_t rowIdx : order) {
+        const SparseRow& row = rows[rowIdx];
+        if (row.empty()) {
+            continue;
+        }
+
+        int32_t minCol = row.front().first;
+        int32_t candidate = (int32_t)firstFree - minCol;
+
+        while (true) {
+            bool fits = true;
+            for (auto& [col, entry] : row) {
+                size_t slot = (size_t)(candidate + col);
+                if (slot < check.size() && check[slot] != -1) {
+                    fits = false;
+                    break;
+                }
+            }
+
+            if (fits) {
+                break;
+            }
+            ++candidate;
+        }
+
+        base[rowIdx] = candidate;
+        for (auto& [col, entry] : row) {
+            size_t slot = (size_t)(candidate + col);
+            if (slot >= check.size()) {
+                check.resize(slot + 1, -1);
+                next.resize(slot + 1, 0);
+            }
+            check[slot] = rowIdx;
+            next[slot] = entry;
+        }
+
+        while (firstFree < check.size() && check[firstFree] != -1) {
+            ++firstFree;
+        }
+    }
+
+    check.shrink_to_fit();
+    next.shrink_to_fit();
+}
+
+// Stores each distinct row once and maps every state to its row id.
+void dedupRows(std::vector<SparseRow>& stateRows, std::vector<uint32_t>& rowOfState, std::vector<SparseRow>& rows) {
+    std::map<SparseRow, uint32_t> rowIds;
+    rowOfState.resize(stateRows.size());
+
+    for (size_t state = 0; state < stateRows.size(); ++state) {
+        auto [it, inserted] = rowIds.try_emplace(std::move(stateRows[state]), (uint32_t)rows.size());
+        if (inserted) {
+            rows.push_back(it->first);
+        }
+        rowOfState[state] = it->second;
+    }
+}
+
+// Sums the visits of the states sharing each row.
+std::vector<uint64_t> rowHeat(const std::vector<uint32_t>& rowOfState, size_t rowCount, const TransitionProfile* profile) {
+    std::vector<uint64_t> heat(rowCount);
+    if (profile) {
+        for (size_t state = 0; state < rowOfState.size(); ++state) {
+            heat[rowOfState[state]] += profile->states.get((long long)state);
+        }
+    }
+    return heat;
+}
+
+// Renumbers columns by falling use, ties keeping their order.
+void orderColumns(std::vector<int32_t>& columns, const std::vector<uint64_t>& heat) {
+    std::vector<int32_t> order(heat.size());
+    for (int32_t i = 0; i < (int32_t)order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int32_t a, int32_t b) {
+        return heat[a] > heat[b];
+    });
+
+    std::vector<int32_t> rank(heat.size());
+    for (int32_t i = 0; i < (int32_t)order.size(); ++i) {
+        rank[order[i]] = i;
+    }
+    for (int32_t& column : columns) {
+        column = rank[column];
+    }
+}
+
+template <typename T>
+size_t vectorBytes(const std::vector<T>& vec) {
+    return vec.capacity() * sizeof(T);
+}
+
+template <typename Map>
+size_t mapBytes(const Map& map) {
+    // One node per element (next pointer plus the stored pair) and one
+    // pointer per bucket, the usual node-based unordered_map layout.
+    return sizeof(Map) + map.size() * (sizeof(void*) + sizeof(typename Map::value_type)) + map.bucket_count() * sizeof(void*);
+}
+
+template <typename Table>
+size_t tableBytes(const Table& table) {
+    size_t bytes = mapBytes(table);
+    for (auto& [state, row] : table) {
+        bytes += mapBytes(row) - sizeof(row);
+    }
+    return bytes;
+}
+
+template <typename Table>
+void collectStates(const Table& table, size_t& stateCount) {
+    for (auto& [state, row] : table) {
+        stateCount = std::max(stateCount, (size_t)state + 1);
+    }
+}
+
+}
+
+void SymbolIndex::build(const std::vector<TokenID>& ids, const std::vector<int32_t>& columns) {
+    mDense.clear();
+    mSparse.clear();
+    mBase = 0;
+
+    if (ids.empty()) {
+        return;
+    }
+
+    auto [minIt, maxIt] = std::minmax_element(ids.begin(), ids.end());
+    if (*maxIt - *minIt < SymbolIndex_maxDenseSpan) {
+        mBase = *minIt;
+        mDense.assign(*maxIt - *minIt + 1, -1);
+        for (size_t i = 0; i < ids.size(); ++i) {
+            mDense[ids[i] - mBase] = columns[i];
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < ids.size(); ++i) {
+        mSparse[ids[i]] = columns[i];
+    }
+}
+
+size_t SymbolIndex::bytes() const {
+    return vectorBytes(mDense) + (mSparse.empty() ? 0 : mapBytes(mSparse));
+}
+
+CompressedTables::CompressedTables(const ParserTables& tables, const TransitionProfile* profile) {
+    size_t stateCount = 0;
+    collectStates(tables.actionTable, stateCount);
+    collectStates(tables.gotoTable, stateCount);
+
+    buildActions(tables, stateCount, profile);
+    buildGotos(tables, stateCount, profile);
+}
+
+void CompressedTables::buildActions(const ParserTables& tables, size_t stateCount, const TransitionProfile* profile) {
+    std::vector<std::unordered_map<TokenID, int32_t>> stateEntries(stateCount);
+    mActionDefault.assign(stateCount, 0);
+
+    // The most frequent reduction of a row becomes its default, so only the
+    // shifts, the accept and the remaining reductions are stored.
+    for (auto& [state, row] : tables.actionTable) {
+        std::map<ParserState, size_t> reduceCounts;
+        for (auto& [tokenId, action] : row) {
+            if (action.type == ParserActType_reduce) {
+                ++reduceCounts[action.value];
+            }
+        }
+
+        ParserState defaultRule = ParserState_none;
+        size_t defaultCount = 0;
+        for (auto& [rule, count] : reduceCounts) {
+            if (count > defaultCount) {
+                defaultRule = rule;
+                defaultCount = count;
+            }
+        }
+
+        int32_t defaultEntry = 0;
+        if (defaultCount) {
+            defaultEntry = encodeAction({ParserActType_reduce, defaultRule});
+        }
+        mActionDefault[state] = defaultEntry;
+
+        for (auto& [tokenId, action] : row) {
+            int32_t entry = encodeAction(action);
+            if (entry != defaultEntry) {
+                stateEntries[state][tokenId] = entry;
+            }
+        }
+    }
+
+    // Terminals whose columns are identical in every state share a class.
+    std::map<TokenID, std::vector<std::pair<uint32_t, int32_t>>> columnsByTerminal;
+    for (size_t state = 0; state < stateCount; ++state) {
+        for (auto& [tokenId, entry] : stateEntries[state]) {
+            columnsByTerminal[tokenId].emplace_back((uint32_t)state, entry);
+        }
+    }
+    for (auto& [state, row] : tables.actionTable) {
+        for (auto& [tokenId, action] : row) {
+            columnsByTerminal.try_emplace(tokenId);
+        }
+    }
+
+    std::map<std::vector<std::pair<uint32_t, int32_t>>, int32_t> classes;
+    std::vector<TokenID> ids;
+    std::vector<int32_t> columns;
+    std::vector<uint64_t> classHeat;
+    for (auto& [tokenId, column] : columnsByTerminal) {
+        auto [it, inserted] = classes.try_emplace(column, (int32_t)classes.size());
+        if (inserted) {
+            classHeat.push_back(0);
+        }
+        if (profile) {
+            classHeat[it->second] += profile->symbols.get(tokenId);
+        }
+        ids.push_back(tokenId);
+        columns.push_back(it->second);
+    }
+    if (profile) {
+        orderColumns(columns, classHeat);
+    }
+    mTerminals.build(ids, columns);
+    mTerminalClasses = classes.size();
+
+    std::vector<SparseRow> stateRows(stateCount);
+    for (size_t state = 0; state < stateCount; ++state) {
+        for (auto& [tokenId, entry] : stateEntries[state]) {
+            stateRows[state].emplace_back(mTerminals.find(tokenId), entry);
+        }
+        std::sort(stateRows[state].begin(), stateRows[state].end());
+        stateRows[state].erase(std::unique(stateRows[state].begin(), stateRows[state].end()), stateRows[state].end());
+    }
+
+    std::vector<SparseRow> rows;
+    dedupRows(stateRows, mActionRowOfState, rows);
+    packRows(rows, rowHeat(mActionRowOfState, rows.size(), profile), mActionBase, mActionNext, mActionCheck);
+}
+
+void CompressedTables::buildGotos(const ParserTables& tables, size_t stateCount, const TransitionProfile* profile) {
+    std::map<TokenID, std::map<ParserState, size_t>> targetCounts;
+    for (auto& [state, row] : tables.gotoTable) {
+        for (auto& [symbolId, target] : row) {
+            ++targetCounts[symbolId][target];
+        }
+    }
+
+    // Each nonterminal's most frequent target becomes the column default.
+    std::vector<TokenID> ids;
+    std::vector<int32_t> columns;
+    std::vector<uint64_t> columnHeat;
+    std::vector<int32_t> defaults;
+    for (auto& [symbolId, counts] : targetCounts) {
+        auto best = std::max_element(counts.begin(), counts.end(), [](auto& a, auto& b) {
+            return a.second < b.second;
+        });
+
+        ids.push_back(symbolId);
+        columns.push_back((int32_t)defaults.size());
+        columnHeat.push_back(profile ? profile->symbols.get(symbolId) : 0);
+        defaults.push_back((int32_t)best->first);
+    }
+    if (profile) {
+        orderColumns(columns, columnHeat);
+    }
+    mGotoDefault.resize(defaults.size());
+    for (size_t i = 0; i < columns.size(); ++i) {
+        mGotoDefault[columns[i]] = defaults[i];
+    }
+    mNonterminals.build(ids, columns);
+
+    std::vector<SparseRow> stateRows(stateCount);
+    for (auto& [state, row] : tables.gotoTable) {
+        for (auto& [symbolId, target] : row) {
+            int32_t column = mNonterminals.find(symbolId);
+            if (mGotoDefault[column] != target) {
+                stateRows[state].emplace_back(column, (int32_t)target);
+            }
+        }
+        std::sort(stateRows[state].begin(), stateRows[state].end());
+    }
+
+    std::vector<SparseRow> rows;
+    dedupRows(stateRows, mGotoRowOfState, rows);
+    packRows(rows, rowHeat(mGotoRowOfState, rows.size(), profile), mGotoBase, mGotoNext, mGotoCheck);
+}
+
+Action CompressedTables::findAction(ParserState state, TokenID tokenId) const {
+    if (state < 0 || state >= (ParserState)mActionRowOfState.size()) {
+        return {};
+    }
+
+    int32_t column = mTerminals.find(tokenId);
+    if (column >= 0) {
+        uint32_t row = mActionRowOfState[state];
+        size_t slot = (size_t)(mActionBase[row] + column);
+        if (slot < mActionCheck.size() && mActionCheck[slot] == (int32_t)row) {
+            return decodeAction(mActionNext[slot]);
+        }
+    }
+    return decodeAction(mActionDefault[state]);
+}
+
+bool CompressedTables::findGoto(ParserState state, TokenID symbolId, ParserState& next) const {
+    if (state < 0 || state >= (ParserState)mGotoRowOfState.size()) {
+        return false;
+    }
+
+    int32_t column = mNonterminals.find(symbolId);
+    if (column < 0) {
+        return false;
+    }
+
+    uint32_t row = mGotoRowOfState[state];
+    size_t slot = (size_t)(mGotoBase[row] + column);
+    if (slot < mGotoCheck.size() && mGotoCheck[slot] == (int32_t)row) {
+        next = mGotoNext[slot];
+        return true;
+    }
+
+    next = mGotoDefault[column];
+    return true;
+}
+
+size_t CompressedTables::bytes() const {
+    return sizeof(*this)
+        + mTerminals.bytes() + vectorBytes(mActionRowOfState) + vectorBytes(mActionDefault)
+        + vectorBytes(mActionBase) + vectorBytes(mActionNext) + vectorBytes(mActionCheck)
+        + mNonterminals.bytes() + vectorBytes(mGotoRowOfState) + vectorBytes(mGotoDefault)
+        + vectorBytes(mGotoBase) + vectorBytes(mGotoNext) + vectorBytes(mGotoCheck);
+}
+
+size_t estimateTableBytes(const ParserTables& tables) {
+    return tableBytes(tables.actionTable) + tableBytes(tables.gotoTable) + mapBytes(tables.defaultReductions);
+}
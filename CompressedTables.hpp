@@ -0,0 +1,86 @@
+#ifndef COMPRESSEDTABLES_HPP
+#define COMPRESSEDTABLES_HPP
+
+#include "ParserDefs.hpp"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct ParserTables;
+struct TransitionProfile;
+
+// Maps symbol ids to dense column indices: a flat array when the ids are
+// clustered, a hash map otherwise.
+class SymbolIndex {
+public:
+    void build(const std::vector<TokenID>& ids, const std::vector<int32_t>& columns);
+
+    int32_t find(TokenID id) const {
+        TokenID offset = id - mBase;
+        if (offset >= 0 && offset < (TokenID)mDense.size()) {
+            return mDense[offset];
+        }
+
+        if (mSparse.empty()) {
+            return -1;
+        }
+
+        auto it = mSparse.find(id);
+        return it == mSparse.end() ? -1 : it->second;
+    }
+
+    size_t bytes() const;
+private:
+    TokenID mBase{};
+    std::vector<int32_t> mDense;
+    std::unordered_map<TokenID, int32_t> mSparse;
+};
+
+// Action and goto tables packed into comb vectors. Terminals with identical
+// columns share one class, every state gets a default reduction, identical
+// rows are stored once and rows are overlaid by displacement with a check
+// array. Gotos use a per-nonterminal default target the same way. With a
+// profile, hot columns get the low indices and hot rows are placed first.
+class CompressedTables {
+public:
+    explicit CompressedTables(const ParserTables& tables, const TransitionProfile* profile = nullptr);
+
+    Action findAction(ParserState state, TokenID tokenId) const;
+    bool findGoto(ParserState state, TokenID symbolId, ParserState& next) const;
+
+    size_t bytes() const;
+    size_t terminalClasses() const {
+        return mTerminalClasses;
+    }
+    size_t actionRows() const {
+        return mActionBase.size();
+    }
+    int32_t terminalColumn(TokenID tokenId) const {
+        return mTerminals.find(tokenId);
+    }
+    int32_t nonterminalColumn(TokenID symbolId) const {
+        return mNonterminals.find(symbolId);
+    }
+private:
+    void buildActions(const ParserTables& tables, size_t stateCount, const TransitionProfile* profile);
+    void buildGotos(const ParserTables& tables, size_t stateCount, const TransitionProfile* profile);
+private:
+    SymbolIndex mTerminals;
+    size_t mTerminalClasses{};
+    std::vector<uint32_t> mActionRowOfState;
+    std::vector<int32_t> mActionDefault;
+    std::vector<int32_t> mActionBase;
+    std::vector<int32_t> mActionNext;
+    std::vector<int32_t> mActionCheck;
+
+    SymbolIndex mNonterminals;
+    std::vector<uint32_t> mGotoRowOfState;
+    std::vector<int32_t> mGotoDefault;
+    std::vector<int32_t> mGotoBase;
+    std::vector<int32_t> mGotoNext;
+    std::vector<int32_t> mGotoCheck;
+};
+
+size_t estimateTableBytes(const ParserTables& tables);
+
+#endif
@@ -0,0 +1,110 @@
+#include "Coroutines.hpp"
+#include <new>
+
+namespace {
+
+constexpr size_t CoroFramePool_granularity = 64;
+constexpr size_t CoroFramePool_buckets = 16;
+
+struct FreeFrame {
+    FreeFrame* next;
+};
+
+struct FrameLists {
+    FreeFrame* heads[CoroFramePool_buckets] {};
+
+    ~FrameLists() {
+        for (FreeFrame*& head : heads) {
+            while (head) {
+                FreeFrame* next = head->next;
+                ::operator delete(head);
+                head = next;
+            }
+        }
+    }
+};
+
+thread_local FrameLists frameLists;
+
+size_t bucketOf(size_t size) {
+    return (size + CoroFramePool_granularity - 1) / CoroFramePool_granularity - 1;
+}
+
+}
+
+void* CoroFramePool::allocate(size_t size) {
+    size_t bucket = bucketOf(size);
+    if (bucket >= CoroFramePool_buckets) {
+        return ::operator new(size);
+    }
+
+    FreeFrame*& head = frameLists.heads[bucket];
+    if (head) {
+        FreeFrame* frame = head;
+        head = frame->next;
+        return frame;
+    }
+    return ::operator new((bucket + 1) * CoroFramePool_granularity);
+}
+
+void CoroFramePool::deallocate(void* ptr, size_t size) {
+    size_t bucket = bucketOf(size);
+    if (bucket >= CoroFramePool_buckets) {
+        ::operator delete(ptr);
+        return;
+    }
+
+    FreeFrame* frame = static_cast<FreeFrame*>(ptr);
+    frame->next = frameLists.heads[bucket];
+    frameLists.heads[bucket] = frame;
+}
+
+Generator<Token> lexTokens(Lexer& lexer, LexerSource& source) {
+    LexerResultInfo resultInfo;
+    Token token;
+
+    while (lexer.next({
+        .token = token,
+        .source = source,
+        .debug = resultInfo,
+    }) == TKN_OK) {
+        co_yield token;
+    }
+}
+
+ParseTask AsyncParseSession::run() {
+    while (true) {
+        co_await DataAwaiter { *this };
+
+        int status = FeedStatus_needMore;
+        if (!mPending.empty()) {
+            std::vector<char> data = std::move(mPending);
+            mPending.clear();
+            status = mSession.feed(data);
+        }
+
+        if (status == FeedStatus_done || status == FeedStatus_err) {
+            co_return status;
+        }
+
+        if (mClosed && mPending.empty()) {
+            co_return mSession.finish();
+        }
+    }
+}
+
+void AsyncParseSession::push(std::span<const char> data) {
+    mPending.insert(mPending.end(), data.begin(), data.end());
+    resume();
+}
+
+void AsyncParseSession::close() {
+    mClosed = true;
+    resume();
+}
+
+void AsyncParseSession::resume() {
+    if (mWaiter) {
+        std::exchange(mWaiter, nullptr).resume();
+    }
+}
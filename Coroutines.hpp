@@ -0,0 +1,217 @@
+#ifndef COROUTINES_HPP
+#define COROUTINES_HPP
+
+#include "ParseSession.hpp"
+#include <coroutine>
+#include <exception>
+#include <span>
+#include <utility>
+#include <vector>
+
+// Thread-local free lists of coroutine frames, bucketed by size. Frames that
+// are too large for a bucket fall back to the global allocator.
+class CoroFramePool {
+public:
+    static void* allocate(size_t size);
+    static void deallocate(void* ptr, size_t size);
+};
+
+struct PooledPromise {
+    static void* operator new(size_t size) {
+        return CoroFramePool::allocate(size);
+    }
+
+    static void operator delete(void* ptr, size_t size) {
+        CoroFramePool::deallocate(ptr, size);
+    }
+};
+
+template <typename T>
+class Generator {
+public:
+    struct promise_type : PooledPromise {
+        const T* value{};
+
+        Generator get_return_object() {
+            return Generator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept {
+            return {};
+        }
+
+        std::suspend_always yield_value(const T& val) noexcept {
+            value = &val;
+            return {};
+        }
+
+        void return_void() { }
+
+        void unhandled_exception() {
+            std::terminate();
+        }
+    };
+
+    class iterator {
+    public:
+        iterator(std::coroutine_handle<promise_type> handle = nullptr) : mHandle(handle) { }
+
+        iterator& operator++() {
+            mHandle.resume();
+            if (mHandle.done()) {
+                mHandle = nullptr;
+            }
+            return *this;
+        }
+
+        const T& operator*() const {
+            return *mHandle.promise().value;
+        }
+
+        bool operator==(const iterator& other) const {
+            return mHandle == other.mHandle;
+        }
+    private:
+        std::coroutine_handle<promise_type> mHandle;
+    };
+
+    Generator(Generator&& other) noexcept : mHandle(std::exchange(other.mHandle, nullptr)) { }
+    Generator(const Generator&) = delete;
+
+    ~Generator() {
+        if (mHandle) {
+            mHandle.destroy();
+        }
+    }
+
+    iterator begin() {
+        if (!mHandle) {
+            return {};
+        }
+
+        mHandle.resume();
+        return mHandle.done() ? iterator() : iterator(mHandle);
+    }
+
+    iterator end() {
+        return {};
+    }
+private:
+    explicit Generator(std::coroutine_handle<promise_type> handle) : mHandle(handle) { }
+private:
+    std::coroutine_handle<promise_type> mHandle;
+};
+
+Generator<Token> lexTokens(Lexer& lexer, LexerSource& source);
+
+class ParseTask {
+public:
+    struct promise_type : PooledPromise {
+        int result = FeedStatus_err;
+        std::coroutine_handle<> continuation;
+
+        ParseTask get_return_object() {
+            return ParseTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_never initial_suspend() noexcept {
+            return {};
+        }
+
+        auto final_suspend() noexcept {
+            struct FinalAwaiter {
+                bool await_ready() noexcept {
+                    return false;
+                }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                    auto continuation = handle.promise().continuation;
+                    return continuation ? continuation : std::noop_coroutine();
+                }
+
+                void await_resume() noexcept { }
+            };
+            return FinalAwaiter {};
+        }
+
+        void return_value(int status) {
+            result = status;
+        }
+
+        void unhandled_exception() {
+            std::terminate();
+        }
+    };
+
+    ParseTask(ParseTask&& other) noexcept : mHandle(std::exchange(other.mHandle, nullptr)) { }
+    ParseTask(const ParseTask&) = delete;
+
+    ~ParseTask() {
+        if (mHandle) {
+            mHandle.destroy();
+        }
+    }
+
+    bool done() const {
+        return !mHandle || mHandle.done();
+    }
+
+    int result() const {
+        return mHandle ? mHandle.promise().result : FeedStatus_err;
+    }
+
+    bool await_ready() const noexcept {
+        return done();
+    }
+
+    void await_suspend(std::coroutine_handle<> continuation) noexcept {
+        mHandle.promise().continuation = continuation;
+    }
+
+    int await_resume() const {
+        return result();
+    }
+private:
+    explicit ParseTask(std::coroutine_handle<promise_type> handle) : mHandle(handle) { }
+private:
+    std::coroutine_handle<promise_type> mHandle;
+};
+
+// ParseSession driven by a coroutine: run() suspends whenever the session
+// needs more input and push()/close() resume it on the caller's thread.
+class AsyncParseSession {
+public:
+    AsyncParseSession(const Parser& parser, Lexer& lexer, ParserValueStack& valueStack, ParserState startState = ParserState_none)
+        : mSession(parser, lexer, valueStack, startState) { }
+
+    ParseTask run();
+    void push(std::span<const char> data);
+    void close();
+private:
+    struct DataAwaiter {
+        AsyncParseSession& session;
+
+        bool await_ready() const noexcept {
+            return !session.mPending.empty() || session.mClosed;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) noexcept {
+            session.mWaiter = handle;
+        }
+
+        void await_resume() const noexcept { }
+    };
+
+    void resume();
+private:
+    ParseSession mSession;
+    std::vector<char> mPending;
+    std::coroutine_handle<> mWaiter;
+    bool mClosed = false;
+};
+
+#endif
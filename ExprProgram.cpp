@@ -0,0 +1,437 @@
+#include "ExprProgram.hpp"
+#include "LexerSources.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+namespace {
+
+constexpr size_t ExprProgram_localStack = 64;
+
+double defaultTerm(const Token& token) {
+    TokenID id = token.info() ? token.info()->id : TKN_NO_ID;
+    if (id != token_integer && id != token_real) {
+        return 0.0;
+    }
+    if (token.getFlags() & TokenFlags_number) {
+        return token.number();
+    }
+    return std::strtod(token.value().c_str(), nullptr);
+}
+
+double applyBinary(ExprBinary_ op, double a, double b) {
+    switch (op) {
+        case ExprBinary_add:
+            return a + b;
+        case ExprBinary_sub:
+            return a - b;
+        case ExprBinary_mul:
+            return a * b;
+        case ExprBinary_div:
+            return a / b;
+        case ExprBinary_pow:
+            return std::pow(a, b);
+        default:
+            return a;
+    }
+}
+
+// A rule with fewer than two values, e.g. a tagged epsilon rule, has no
+// operands and gives 0.
+template <ExprBinary_ Op>
+double binaryHandler(std::span<double> values) {
+    if (values.size() < 2) {
+        return 0.0;
+    }
+    return applyBinary(Op, values.front(), values.back());
+}
+
+// One instruction over a batch: fixed trip counts on separate slots, which
+// the compiler turns into vector code.
+template <typename Apply>
+void applyLanes(double* lhs, const double* rhs, Apply apply) {
+    for (size_t lane = 0; lane < ExprProgram_lanes; ++lane) {
+        lhs[lane] = apply(lhs[lane], rhs[lane]);
+    }
+}
+
+void binaryLanes(ExprBinary_ op, double* lhs, const double* rhs) {
+    switch (op) {
+        case ExprBinary_add:
+            applyLanes(lhs, rhs, [](double a, double b) { return a + b; });
+            break;
+        case ExprBinary_sub:
+            applyLanes(lhs, rhs, [](double a, double b) { return a - b; });
+            break;
+        case ExprBinary_mul:
+            applyLanes(lhs, rhs, [](double a, double b) { return a * b; });
+            break;
+        case ExprBinary_div:
+            applyLanes(lhs, rhs, [](double a, double b) { return a / b; });
+            break;
+        case ExprBinary_pow:
+            applyLanes(lhs, rhs, [](double a, double b) { return std::pow(a, b); });
+            break;
+        default:
+            break;
+    }
+}
+
+}
+
+ExprHandlers& ExprHandlers::onBinary(RuleTag tag, ExprBinary_ op) {
+    static const ReduceHandler handlers[] = {
+        nullptr,
+        binaryHandler<ExprBinary_add>,
+        binaryHandler<ExprBinary_sub>,
+        binaryHandler<ExprBinary_mul>,
+        binaryHandler<ExprBinary_div>,
+        binaryHandler<ExprBinary_pow>
+    };
+
+    onReduce(tag, handlers[op]);
+    if (tag >= 0) {
+        binary.resize(reduce.size(), ExprBinary_none);
+        binary[tag] = op;
+    }
+    return *this;
+}
+
+double ExprProgram::evaluate(std::span<const double> variables) const {
+    if (variables.size() < mVariables.size()) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    double local[ExprProgram_localStack];
+    std::vector<double> heap;
+    double* stack = local;
+    if (mMaxDepth > ExprProgram_localStack) {
+        heap.resize(mMaxDepth);
+        stack = heap.data();
+    }
+
+    double args[UINT8_MAX];
+    double* top = stack;
+    for (const ExprInstr& instr : mCode) {
+        switch (instr.op) {
+            case ExprOp_const:
+                *top++ = mConstants[instr.operand];
+                break;
+            case ExprOp_var:
+                *top++ = variables[instr.operand];
+                break;
+            case ExprOp_reduce:
+                top -= instr.count;
+                if (instr.layout) {
+                    const std::vector<bool>& layout = mLayouts[instr.layout - 1];
+                    const double* value = top;
+                    for (size_t i = 0; i < layout.size(); ++i) {
+                        args[i] = layout[i] ? *value++ : 0.0;
+                    }
+                    *top = mHandlers[instr.operand](std::span<double>(args, layout.size()));
+                } else {
+                    *top = mHandlers[instr.operand](std::span<double>(top, instr.count));
+                }
+                ++top;
+                break;
+            case ExprOp_keepFirst:
+                top -= instr.count - 1;
+                break;
+            case ExprOp_pop:
+                --top;
+                break;
+            case ExprOp_binary:
+                top -= instr.count;
+                *top = applyBinary((ExprBinary_)instr.operand, top[0], top[instr.count - 1]);
+                ++top;
+                break;
+        }
+    }
+    return top > stack ? top[-1] : 0.0;
+}
+
+bool ExprProgram::evaluateColumns(std::span<const double* const> columns, size_t rows, double* out) const {
+    constexpr size_t lanes = ExprProgram_lanes;
+    if (columns.size() < mVariables.size()) {
+        return false;
+    }
+
+    // One slot of lanes per stack entry; tail rows pad the unused lanes.
+    std::vector<double> stack(std::max<size_t>(mMaxDepth, 1) * lanes);
+    std::vector<double> values;
+    for (size_t row = 0; row < rows; row += lanes) {
+        size_t count = std::min(lanes, rows - row);
+        double* top = stack.data();
+
+        for (const ExprInstr& instr : mCode) {
+            switch (instr.op) {
+                case ExprOp_const:
+                    std::fill(top, top + lanes, mConstants[instr.operand]);
+                    top += lanes;
+                    break;
+                case ExprOp_var: {
+                    const double* column = columns[instr.operand] + row;
+                    std::copy(column, column + count, top);
+                    std::fill(top + count, top + lanes, 0.0);
+                    top += lanes;
+                    break;
+                }
+                case ExprOp_reduce: {
+                    const std::vector<bool>* layout = instr.layout ? &mLayouts[instr.layout - 1] : nullptr;
+                    top -= instr.count * lanes;
+                    values.resize(layout ? layout->size() : instr.count);
+                    for (size_t lane = 0; lane < lanes; ++lane) {
+                        const double* value = top + lane;
+                        for (size_t i = 0; i < values.size(); ++i) {
+                            if (layout && !(*layout)[i]) {
+                                values[i] = 0.0;
+                            } else {
+                                values[i] = *value;
+                                value += lanes;
+                            }
+                        }
+                        top[lane] = mHandlers[instr.operand](values);
+                    }
+                    top += lanes;
+                    break;
+                }
+                case ExprOp_keepFirst:
+                    top -= (instr.count - 1) * lanes;
+                    break;
+                case ExprOp_pop:
+                    top -= lanes;
+                    break;
+                case ExprOp_binary:
+                    top -= instr.count * lanes;
+                    binaryLanes((ExprBinary_)instr.operand, top, top + (instr.count - 1) * lanes);
+                    top += lanes;
+                    break;
+            }
+        }
+
+        if (top == stack.data()) {
+            std::fill(out + row, out + row + count, 0.0);
+        } else {
+            std::copy(top - lanes, top - lanes + count, out + row);
+        }
+    }
+    return true;
+}
+
+ExprCompiler::ExprCompiler(const ExprHandlers& handlers, std::span<const std::string> variables)
+    : mHandlers(handlers), mBound(!variables.empty()) {
+    mProgram.mVariables.assign(variables.begin(), variables.end());
+}
+
+void ExprCompiler::push(ExprInstr instr, ExprSlot_ slot) {
+    mProgram.mCode.push_back(instr);
+    mSlots.push_back(slot);
+    mProgram.mMaxDepth = std::max(mProgram.mMaxDepth, ++mDepth);
+}
+
+void ExprCompiler::pushConstant(double value) {
+    push({ ExprOp_const, 0, 0, (int32_t)mProgram.mConstants.size() }, ExprSlot_constant);
+    mProgram.mConstants.push_back(value);
+}
+
+void ExprCompiler::replaceSlots(size_t base, size_t values) {
+    mSlots.resize(base);
+    mSlots.push_back(ExprSlot_value);
+    mDepth = mDepth - values + 1;
+}
+
+int ExprCompiler::pushTerm(const Token& token) {
+    TokenID id = token.info() ? token.info()->id : TKN_NO_ID;
+    if (mHandlers.term && id != token_id) {
+        pushConstant(mHandlers.term(token));
+        return 0;
+    }
+    if (id == token_integer || id == token_real) {
+        pushConstant(defaultTerm(token));
+        return 0;
+    }
+    if (id != token_id) {
+        mSlots.push_back(ExprSlot_none);
+        return 0;
+    }
+
+    std::vector<std::string>& names = mProgram.mVariables;
+    auto it = std::find(names.begin(), names.end(), token.value());
+    if (it == names.end()) {
+        if (mBound) {
+            mFailed = true;
+            return -1;
+        }
+        it = names.insert(names.end(), token.value());
+    }
+    push({ ExprOp_var, 0, 0, (int32_t)(it - names.begin()) }, ExprSlot_value);
+    return 0;
+}
+
+bool ExprCompiler::pushReduced(const GrammarRule& rule) {
+    if (rule.rhsSize > mSlots.size() || rule.rhsSize > UINT8_MAX) {
+        mFailed = true;
+        return false;
+    }
+
+    ExprHandlers::ReduceHandler handler = nullptr;
+    if (rule.tag >= 0 && (size_t)rule.tag < mHandlers.reduce.size()) {
+        handler = mHandlers.reduce[rule.tag];
+    }
+
+    uint8_t count = (uint8_t)rule.rhsSize;
+    size_t base = mSlots.size() - count;
+    auto first = mSlots.begin() + base;
+    uint8_t values = (uint8_t)std::count_if(first, mSlots.end(), [](ExprSlot_ slot) { return slot != ExprSlot_none; });
+
+    if (!handler) {
+        if (count == 0) {
+            mSlots.push_back(ExprSlot_none);
+        } else if (*first == ExprSlot_none) {
+            while (mSlots.size() > base) {
+                pop();
+            }
+            mSlots.push_back(ExprSlot_none);
+        } else if (values > 1) {
+            mProgram.mCode.push_back({ ExprOp_keepFirst, values });
+            replaceSlots(base, values);
+        } else {
+            mSlots.resize(base + 1);
+        }
+        return true;
+    }
+
+    // Arguments that are all constants are the last instructions, so the
+    // reduction is folded into one constant.
+    if (std::none_of(first, mSlots.end(), [](ExprSlot_ slot) { return slot == ExprSlot_value; })) {
+        std::vector<ExprInstr>& code = mProgram.mCode;
+        std::vector<double> args;
+        size_t instr = code.size() - values;
+        for (auto it = first; it != mSlots.end(); ++it) {
+            args.push_back(*it == ExprSlot_none ? 0.0 : mProgram.mConstants[code[instr++].operand]);
+        }
+        mProgram.mConstants.resize(mProgram.mConstants.size() - values);
+        code.resize(code.size() - values);
+        mSlots.resize(base);
+        mDepth -= values;
+        pushConstant(handler(args));
+        return true;
+    }
+
+    ExprBinary_ binary = (size_t)rule.tag < mHandlers.binary.size() ? mHandlers.binary[rule.tag] : ExprBinary_none;
+    if (binary != ExprBinary_none && count > 1 && *first != ExprSlot_none && mSlots.back() != ExprSlot_none) {
+        mProgram.mCode.push_back({ ExprOp_binary, values, 0, binary });
+        replaceSlots(base, values);
+        return true;
+    }
+
+    // Operator tokens among the symbols take no stack slot; the layout
+    // tells the program where to put their 0 in the handler's values.
+    uint16_t layout = 0;
+    if (values < count) {
+        std::vector<bool> present;
+        for (auto it = first; it != mSlots.end(); ++it) {
+            present.push_back(*it != ExprSlot_none);
+        }
+
+        std::vector<std::vector<bool>>& layouts = mProgram.mLayouts;
+        auto it = std::find(layouts.begin(), layouts.end(), present);
+        if (it == layouts.end()) {
+            if (layouts.size() >= UINT16_MAX) {
+                mFailed = true;
+                return false;
+            }
+            it = layouts.insert(it, std::move(present));
+        }
+        layout = (uint16_t)(it - layouts.begin() + 1);
+    }
+
+    auto it = std::find(mProgram.mHandlers.begin(), mProgram.mHandlers.end(), handler);
+    if (it == mProgram.mHandlers.end()) {
+        it = mProgram.mHandlers.insert(it, handler);
+    }
+    mProgram.mCode.push_back({ ExprOp_reduce, values, layout, (int32_t)(it - mProgram.mHandlers.begin()) });
+    replaceSlots(base, values);
+    return true;
+}
+
+bool ExprCompiler::pop() {
+    if (mSlots.empty()) {
+        return false;
+    }
+
+    ExprSlot_ slot = mSlots.back();
+    mSlots.pop_back();
+    if (slot == ExprSlot_none) {
+        return true;
+    }
+
+    --mDepth;
+    std::vector<ExprInstr>& code = mProgram.mCode;
+    if (slot == ExprSlot_constant && code.back().op == ExprOp_const) {
+        code.pop_back();
+        mProgram.mConstants.pop_back();
+        return true;
+    }
+
+    code.push_back({ ExprOp_pop });
+    std::replace(mSlots.begin(), mSlots.end(), ExprSlot_constant, ExprSlot_value);
+    return true;
+}
+
+ExprProgram ExprCompiler::take() {
+    ExprProgram program = std::move(mProgram);
+    mProgram = {};
+    mSlots.clear();
+    mDepth = 0;
+    mFailed = false;
+    if (mBound) {
+        mProgram.mVariables = program.mVariables;
+    }
+    return program;
+}
+
+ExprCache::ExprCache(const Parser& parser, const Lexer& lexer, const ExprHandlers& handlers, std::vector<std::string> variables, size_t capacity)
+    : mParser(parser), mLexer(lexer), mHandlers(handlers), mVariables(std::move(variables)), mCapacity(std::max<size_t>(capacity, 1)) { }
+
+std::shared_ptr<const ExprProgram> ExprCache::find(std::string_view text) {
+    auto it = mIndex.find(text);
+    if (it != mIndex.end()) {
+        ++mHits;
+        mEntries.splice(mEntries.begin(), mEntries, it->second);
+        return it->second->program;
+    }
+
+    ++mMisses;
+    if (mEntries.size() >= mCapacity) {
+        mIndex.erase(mEntries.back().text);
+        mEntries.pop_back();
+    }
+
+    mEntries.push_front({ std::string(text), compile(text) });
+    mIndex.emplace(mEntries.front().text, mEntries.begin());
+    return mEntries.front().program;
+}
+
+std::shared_ptr<const ExprProgram> ExprCache::compile(std::string_view text) {
+    StringViewSource source(text);
+    LexerResultInfo resultInfo;
+    ExprCompiler compiler(mHandlers, mVariables);
+    const ParserState startState = 0;
+
+    mParser.reset();
+    int status = ParseStatus_ok;
+    while (ParseStatus_ok == (status = mParser.parseNext(BasicParserInputArgs<ExprCompiler> {
+        .lexer = mLexer,
+        .source = source,
+        .lexerResInfo = resultInfo,
+        .valueStack = compiler,
+        .startState = startState,
+    })));
+
+    if (status != ParseStatus_finish || compiler.failed()) {
+        return nullptr;
+    }
+    return std::make_shared<const ExprProgram>(compiler.take());
+}
@@ -0,0 +1,188 @@
+#ifndef EXPRPROGRAM_HPP
+#define EXPRPROGRAM_HPP
+
+#include "Parser.hpp"
+#include <list>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+enum ExprBinary_ : uint8_t {
+    ExprBinary_none,
+    ExprBinary_add,
+    ExprBinary_sub,
+    ExprBinary_mul,
+    ExprBinary_div,
+    ExprBinary_pow
+};
+
+// Semantic actions of a compiled expression, with the signatures of
+// TypedValueStack<double>. Reduce handlers are indexed by rule tag and must
+// be pure: reductions of constants are folded at compile time. Without a
+// term handler, int and real tokens give their value and other tokens none:
+// they take no stack slot and read as 0 in the values of a reduction.
+struct ExprHandlers {
+    using TermHandler = double (*)(const Token& token);
+    using ReduceHandler = double (*)(std::span<double> values);
+
+    TermHandler term{};
+    std::vector<ReduceHandler> reduce;
+    std::vector<ExprBinary_> binary;
+
+    ExprHandlers& onTerm(TermHandler handler) {
+        term = handler;
+        return *this;
+    }
+
+    ExprHandlers& onReduce(RuleTag tag, ReduceHandler handler) {
+        if (tag < 0) {
+            return *this;
+        }
+
+        if ((size_t)tag >= reduce.size()) {
+            reduce.resize(tag + 1, nullptr);
+        }
+        reduce[tag] = handler;
+        if ((size_t)tag < binary.size()) {
+            binary[tag] = ExprBinary_none;
+        }
+        return *this;
+    }
+
+    // A built-in operator on the first and last value of the rule, which
+    // programs run inline and evaluateColumns() vectorizes.
+    ExprHandlers& onBinary(RuleTag tag, ExprBinary_ op);
+};
+
+enum ExprOp_ : uint8_t {
+    ExprOp_const,
+    ExprOp_var,
+    ExprOp_reduce,
+    ExprOp_keepFirst,
+    ExprOp_pop,
+    ExprOp_binary
+};
+
+struct ExprInstr {
+    ExprOp_ op{};
+    uint8_t count{};        // values a reduce, keepFirst or binary op takes off the stack
+    uint16_t layout{};      // 1 + layout index of a reduce over operator tokens, else 0
+    int32_t operand{};      // constant, variable or handler index, or the ExprBinary_ of a binary op
+};
+
+// Postfix stack code for one parse. Identifiers are variables, numbered in
+// the order of the list the program was compiled against, or else of
+// first appearance.
+constexpr size_t ExprProgram_lanes = 16;
+
+class ExprProgram {
+public:
+    // NaN when fewer values than variables are given.
+    double evaluate(std::span<const double> variables) const;
+
+    // Evaluates every row of the columns, columns[i] holding the values of
+    // variables()[i], into out. Rows go through ExprProgram_lanes at a
+    // time, each instruction running over all lanes of a batch. False when
+    // fewer columns than variables are given.
+    bool evaluateColumns(std::span<const double* const> columns, size_t rows, double* out) const;
+
+    const std::vector<std::string>& variables() const {
+        return mVariables;
+    }
+
+    size_t size() const {
+        return mCode.size();
+    }
+
+    std::span<const ExprInstr> code() const {
+        return mCode;
+    }
+private:
+    friend class ExprCompiler;
+
+    std::vector<ExprInstr> mCode;
+    std::vector<double> mConstants;
+    std::vector<ExprHandlers::ReduceHandler> mHandlers;
+    std::vector<std::vector<bool>> mLayouts;   // which symbols of a reduce have a value
+    std::vector<std::string> mVariables;
+    size_t mMaxDepth{};
+};
+
+enum ExprSlot_ : uint8_t {
+    ExprSlot_none,          // an operator token, with no value on the program's stack
+    ExprSlot_constant,
+    ExprSlot_value
+};
+
+// Value stack that records the reductions of a parse as an ExprProgram
+// instead of running them. Untagged single-symbol rules emit nothing.
+class ExprCompiler final : public ParserValueStack {
+public:
+    ExprCompiler(const ExprHandlers& handlers, std::span<const std::string> variables = {});
+
+    int pushTerm(const Token& token) override;
+    bool pushReduced(const GrammarRule& rule) override;
+    bool pop() override;
+
+    // An identifier outside the bound variables or an over-long rule.
+    bool failed() const {
+        return mFailed;
+    }
+
+    ExprProgram take();
+private:
+    void push(ExprInstr instr, ExprSlot_ slot);
+    void pushConstant(double value);
+    void replaceSlots(size_t base, size_t values);
+private:
+    const ExprHandlers& mHandlers;
+    bool mBound{};
+    bool mFailed{};
+    ExprProgram mProgram;
+    std::vector<ExprSlot_> mSlots;
+    size_t mDepth{};
+};
+
+// Compiled programs by input text, least recently used evicted first. A
+// text that does not parse is cached as nullptr. Not thread-safe; use one
+// cache per thread.
+class ExprCache {
+public:
+    ExprCache(const Parser& parser, const Lexer& lexer, const ExprHandlers& handlers, std::vector<std::string> variables = {}, size_t capacity = 1024);
+
+    std::shared_ptr<const ExprProgram> find(std::string_view text);
+
+    size_t size() const {
+        return mEntries.size();
+    }
+
+    size_t hits() const {
+        return mHits;
+    }
+
+    size_t misses() const {
+        return mMisses;
+    }
+private:
+    struct Entry {
+        std::string text;
+        std::shared_ptr<const ExprProgram> program;
+    };
+
+    std::shared_ptr<const ExprProgram> compile(std::string_view text);
+private:
+    Parser mParser;
+    Lexer mLexer;
+    ExprHandlers mHandlers;
+    std::vector<std::string> mVariables;
+    size_t mCapacity;
+    std::list<Entry> mEntries;
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> mIndex;
+    size_t mHits{};
+    size_t mMisses{};
+};
+
+#endif
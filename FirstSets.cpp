@@ -0,0 +1,248 @@
+#include "FirstSets.hpp"
+#include "ParserBuilder.hpp"
+#include "Tracer.hpp"
+#include <algorithm>
+
+namespace {
+
+void setBit(std::span<FirstSets::Word> row, int32_t bit) {
+    row[bit / 64] |= FirstSets::Word(1) << (bit % 64);
+}
+
+bool orInto(std::span<FirstSets::Word> dst, std::span<const FirstSets::Word> src) {
+    FirstSets::Word changed = 0;
+    for (size_t i = 0; i < dst.size(); ++i) {
+        changed |= src[i] & ~dst[i];
+        dst[i] |= src[i];
+    }
+    return changed != 0;
+}
+
+std::vector<int32_t> denseColumns(size_t count) {
+    std::vector<int32_t> columns(count);
+    for (size_t i = 0; i < count; ++i) {
+        columns[i] = (int32_t)i;
+    }
+    return columns;
+}
+
+}
+
+void FirstSets::compute(const std::vector<TokRule>& rules) {
+    TraceScope trace("computeFirstSets", "builder");
+    std::vector<TokenID> nonterminalIds;
+    mTerminalIds.clear();
+
+    for (const TokRule& rule : rules) {
+        nonterminalIds.push_back(rule.lhs.info()->id);
+        for (const Token& sym : rule.rhs) {
+            if (sym.info()->category == TokenCategory_term) {
+                mTerminalIds.push_back(sym.info()->id);
+            } else if (sym.info()->category == TokenCategory_nonterm) {
+                nonterminalIds.push_back(sym.info()->id);
+            }
+        }
+    }
+
+    for (std::vector<TokenID>* ids : {&mTerminalIds, &nonterminalIds}) {
+        std::sort(ids->begin(), ids->end());
+        ids->erase(std::unique(ids->begin(), ids->end()), ids->end());
+    }
+
+    mTerminals.build(mTerminalIds, denseColumns(mTerminalIds.size()));
+    mNonterminals.build(nonterminalIds, denseColumns(nonterminalIds.size()));
+
+    mRulesByLhs.assign(nonterminalIds.size(), {});
+    for (int rIdx = 0; rIdx < (int)rules.size(); ++rIdx) {
+        mRulesByLhs[mNonterminals.find(rules[rIdx].lhs.info()->id)].push_back(rIdx);
+    }
+
+    computeNullable(rules);
+
+    mWords = (mTerminalIds.size() + 63) / 64;
+    mFirst.assign(nonterminalIds.size() * mWords, 0);
+
+    // A -> B ... makes FIRST(A) depend on FIRST(B); terminals reached through
+    // a nullable prefix go straight into the row.
+    std::vector<std::vector<int32_t>> edges(nonterminalIds.size());
+    for (const TokRule& rule : rules) {
+        int32_t lhs = mNonterminals.find(rule.lhs.info()->id);
+        std::span<Word> row(mFirst.data() + lhs * mWords, mWords);
+
+        for (const Token& sym : rule.rhs) {
+            if (sym.info()->category == TokenCategory_term) {
+                setBit(row, mTerminals.find(sym.info()->id));
+                break;
+            }
+            if (sym.info()->category != TokenCategory_nonterm) {
+                break;
+            }
+
+            int32_t nonterminal = mNonterminals.find(sym.info()->id);
+            edges[lhs].push_back(nonterminal);
+            if (!mNullable[nonterminal]) {
+                break;
+            }
+        }
+    }
+
+    for (std::vector<int32_t>& targets : edges) {
+        std::sort(targets.begin(), targets.end());
+        targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+    }
+
+    // Components come out with everything they depend on already final, so a
+    // component without a cycle needs one pass and a cyclic one converges
+    // without touching the rest of the grammar.
+    for (const std::vector<int32_t>& component : componentsInOrder(edges)) {
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (int32_t node : component) {
+                std::span<Word> row(mFirst.data() + node * mWords, mWords);
+                for (int32_t target : edges[node]) {
+                    if (target != node && orInto(row, first(target))) {
+                        changed = true;
+                    }
+                }
+            }
+            changed = changed && component.size() > 1;
+        }
+    }
+}
+
+void FirstSets::computeNullable(const std::vector<TokRule>& rules) {
+    size_t count = mRulesByLhs.size();
+    mNullable.assign(count, false);
+
+    // Every rule counts the right-hand symbols not yet known to be nullable;
+    // a rule reaching zero makes its left-hand side nullable.
+    std::vector<size_t> pending(rules.size());
+    std::vector<std::vector<int>> occurrences(count);
+    std::vector<int32_t> worklist;
+
+    for (int rIdx = 0; rIdx < (int)rules.size(); ++rIdx) {
+        const TokRule& rule = rules[rIdx];
+        pending[rIdx] = rule.rhs.size();
+
+        bool onlyNonterminals = true;
+        for (const Token& sym : rule.rhs) {
+            if (sym.info()->category != TokenCategory_nonterm) {
+                onlyNonterminals = false;
+                break;
+            }
+        }
+
+        if (!onlyNonterminals) {
+            continue;
+        }
+
+        for (const Token& sym : rule.rhs) {
+            occurrences[mNonterminals.find(sym.info()->id)].push_back(rIdx);
+        }
+
+        int32_t lhs = mNonterminals.find(rule.lhs.info()->id);
+        if (rule.rhs.empty() && !mNullable[lhs]) {
+            mNullable[lhs] = true;
+            worklist.push_back(lhs);
+        }
+    }
+
+    while (!worklist.empty()) {
+        int32_t nonterminal = worklist.back();
+        worklist.pop_back();
+
+        for (int rIdx : occurrences[nonterminal]) {
+            if (--pending[rIdx] != 0) {
+                continue;
+            }
+
+            int32_t lhs = mNonterminals.find(rules[rIdx].lhs.info()->id);
+            if (!mNullable[lhs]) {
+                mNullable[lhs] = true;
+                worklist.push_back(lhs);
+            }
+        }
+    }
+}
+
+std::vector<std::vector<int32_t>> FirstSets::componentsInOrder(const std::vector<std::vector<int32_t>>& edges) const {
+    constexpr int32_t unvisited = -1;
+
+    // Iterative Tarjan: a component is emitted only after every component
+    // reachable from it.
+    std::vector<std::vector<int32_t>> components;
+    std::vector<int32_t> index(edges.size(), unvisited);
+    std::vector<int32_t> lowLink(edges.size());
+    std::vector<bool> onStack(edges.size());
+    std::vector<int32_t> stack;
+    std::vector<std::pair<int32_t, size_t>> callStack;
+    int32_t nextIndex = 0;
+
+    for (int32_t root = 0; root < (int32_t)edges.size(); ++root) {
+        if (index[root] != unvisited) {
+            continue;
+        }
+
+        callStack.emplace_back(root, 0);
+        while (!callStack.empty()) {
+            auto& [node, edge] = callStack.back();
+
+            if (edge == 0) {
+                index[node] = lowLink[node] = nextIndex++;
+                stack.push_back(node);
+                onStack[node] = true;
+            }
+
+            if (edge < edges[node].size()) {
+                int32_t target = edges[node][edge++];
+                if (index[target] == unvisited) {
+                    callStack.emplace_back(target, 0);
+                } else if (onStack[target]) {
+                    lowLink[node] = std::min(lowLink[node], index[target]);
+                }
+                continue;
+            }
+
+            if (lowLink[node] == index[node]) {
+                std::vector<int32_t>& component = components.emplace_back();
+                int32_t member;
+                do {
+                    member = stack.back();
+                    stack.pop_back();
+                    onStack[member] = false;
+                    component.push_back(member);
+                } while (member != node);
+            }
+
+            int32_t done = node;
+            callStack.pop_back();
+            if (!callStack.empty()) {
+                int32_t parent = callStack.back().first;
+                lowLink[parent] = std::min(lowLink[parent], lowLink[done]);
+            }
+        }
+    }
+    return components;
+}
+
+bool FirstSets::firstOf(const TokRule& rule, size_t start, std::span<Word> out) const {
+    for (size_t i = start; i < rule.rhs.size(); ++i) {
+        const TokenInfo* info = rule.rhs[i].info();
+
+        if (info->category == TokenCategory_term) {
+            setBit(out, mTerminals.find(info->id));
+            return false;
+        }
+        if (info->category != TokenCategory_nonterm) {
+            return false;
+        }
+
+        int32_t nonterminal = mNonterminals.find(info->id);
+        orInto(out, first(nonterminal));
+        if (!mNullable[nonterminal]) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,78 @@
+#ifndef FIRSTSETS_HPP
+#define FIRSTSETS_HPP
+
+#include "CompressedTables.hpp"
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+struct TokRule;
+
+// Nullable flags and FIRST sets of a grammar over dense symbol indices. Each
+// nonterminal owns a bitset row over the terminals; rows are propagated once
+// per strongly connected component of the "begins with" graph, components
+// taken in reverse topological order. Epsilon is the nullable flag rather
+// than a member of the sets.
+class FirstSets {
+public:
+    using Word = uint64_t;
+
+    void compute(const std::vector<TokRule>& rules);
+
+    size_t words() const {
+        return mWords;
+    }
+
+    int32_t terminalIndex(TokenID id) const {
+        return mTerminals.find(id);
+    }
+
+    int32_t nonterminalIndex(TokenID id) const {
+        return mNonterminals.find(id);
+    }
+
+    TokenID terminal(size_t index) const {
+        return mTerminalIds[index];
+    }
+
+    bool nullable(int32_t nonterminal) const {
+        return mNullable[nonterminal];
+    }
+
+    std::span<const Word> first(int32_t nonterminal) const {
+        return std::span<const Word>(mFirst.data() + nonterminal * mWords, mWords);
+    }
+
+    // Rule indices by left-hand side, for closure.
+    const std::vector<int>& rulesOf(int32_t nonterminal) const {
+        return mRulesByLhs[nonterminal];
+    }
+
+    // ORs FIRST(rule.rhs[start..]) into out and returns whether the whole
+    // suffix can derive epsilon.
+    bool firstOf(const TokRule& rule, size_t start, std::span<Word> out) const;
+
+    template <typename Fn>
+    void forEachTerminal(std::span<const Word> row, Fn&& fn) const {
+        for (size_t word = 0; word < row.size(); ++word) {
+            for (Word bits = row[word]; bits; bits &= bits - 1) {
+                fn(mTerminalIds[word * 64 + std::countr_zero(bits)]);
+            }
+        }
+    }
+private:
+    void computeNullable(const std::vector<TokRule>& rules);
+    std::vector<std::vector<int32_t>> componentsInOrder(const std::vector<std::vector<int32_t>>& edges) const;
+private:
+    SymbolIndex mTerminals;
+    SymbolIndex mNonterminals;
+    std::vector<TokenID> mTerminalIds;
+    std::vector<std::vector<int>> mRulesByLhs;
+
+    size_t mWords{};
+    std::vector<bool> mNullable;
+    std::vector<Word> mFirst;
+};
+
+#endif
@@ -0,0 +1,426 @@
+#include "GrammarLoader.hpp"
+#include "ParserBuilder.hpp"
+#include <cctype>
+#include <charconv>
+
+namespace {
+
+TokenID builtinTerminal(std::string_view name) {
+    if (name == "int") {
+        return token_integer;
+    }
+    if (name == "real") {
+        return token_real;
+    }
+    if (name == "id") {
+        return token_id;
+    }
+
+    if (name.size() == 1) {
+        size_t op = LEXER_DEFAULT_OP_CHARS.find(name[0]);
+        if (op != std::string::npos) {
+            return LEXER_DEFAULT_OP_IDS[op];
+        }
+    }
+    return TKN_NO_ID;
+}
+
+bool isNameChar(int ch) {
+    return std::isalnum(ch) || ch == '_';
+}
+
+}
+
+const GrammarSymbol* GrammarSymbols::add(std::string_view name, TokenID category) {
+    if (const GrammarSymbol* symbol = find(name)) {
+        return symbol->info.category == category ? symbol : nullptr;
+    }
+
+    TokenID id = TKN_NO_ID;
+    if (category == TokenCategory_nonterm) {
+        id = mNextNonterminal++;
+    } else if ((id = builtinTerminal(name)) == TKN_NO_ID) {
+        id = mNextTerminal++;
+    }
+
+    GrammarSymbol& symbol = mSymbols.emplace_back(GrammarSymbol {
+        .name = std::string(name),
+        .info = { .id = id, .category = category, .value = std::string(name) }
+    });
+    mIndex.emplace(symbol.name, (uint32_t)mSymbols.size() - 1);
+    return &symbol;
+}
+
+RuleTag GrammarSymbols::addTag(std::string_view name) {
+    auto [it, inserted] = mTags.try_emplace(std::string(name), mNextTag);
+    if (inserted) {
+        ++mNextTag;
+    }
+    return it->second;
+}
+
+LexerBuilder& GrammarSymbols::addTerminals(LexerBuilder& builder) const {
+    for (const GrammarSymbol& symbol : mSymbols) {
+        if (symbol.info.category != TokenCategory_term || symbol.info.id < GrammarSymbols_firstTerminal) {
+            continue;
+        }
+
+        // Punctuation such as "==" or "->" is never read as a word, so it
+        // has to go through the operator trie to be lexed at all.
+        if (isNameChar((unsigned char)symbol.name[0])) {
+            builder.addStatic(symbol.name.c_str(), { .id = symbol.info.id });
+        } else {
+            builder.addOperator(symbol.name, symbol.info.id);
+        }
+    }
+    return builder;
+}
+
+void GrammarSymbols::clear() {
+    mIndex.clear();
+    mSymbols.clear();
+    mTags.clear();
+    mNextTag = 1;
+    mNextTerminal = GrammarSymbols_firstTerminal;
+    mNextNonterminal = GrammarSymbols_firstNonterminal;
+}
+
+GrammarLoader::GrammarTok GrammarLoader::scan() {
+    using Traits = std::streambuf::traits_type;
+
+    while (true) {
+        int ch = mStream.sgetc();
+
+        if (ch == Traits::eof()) {
+            return { GrammarTok_end, {}, mLine };
+        }
+
+        if (ch == '\n') {
+            ++mLine;
+        }
+
+        if (std::isspace(ch)) {
+            mStream.sbumpc();
+            continue;
+        }
+
+        if (ch == '#') {
+            while (ch != Traits::eof() && ch != '\n') {
+                ch = mStream.snextc();
+            }
+            continue;
+        }
+
+        mStream.sbumpc();
+        GrammarTok tok { GrammarTok_name, {}, mLine };
+
+        switch (ch) {
+            case '|':
+                tok.type = GrammarTok_bar;
+                return tok;
+
+            case ';':
+                tok.type = GrammarTok_semicolon;
+                return tok;
+
+            case '-':
+                if (mStream.sgetc() == '>') {
+                    mStream.sbumpc();
+                    tok.type = GrammarTok_arrow;
+                    return tok;
+                }
+                tok.type = GrammarTok_quoted;
+                tok.text = "-";
+                return tok;
+
+            case '@':
+                tok.type = GrammarTok_tag;
+                while (isNameChar(mStream.sgetc())) {
+                    tok.text += (char)mStream.sbumpc();
+                }
+                if (tok.text.empty()) {
+                    return { GrammarTok_err, "Expected a tag name after '@'", mLine };
+                }
+                return tok;
+
+            case '%':
+                if (!std::isalpha(mStream.sgetc())) {
+                    tok.type = GrammarTok_quoted;
+                    tok.text = "%";
+                    return tok;
+                }
+
+                tok.type = GrammarTok_directive;
+                while (isNameChar(mStream.sgetc())) {
+                    tok.text += (char)mStream.sbumpc();
+                }
+                return tok;
+
+            case '\'':
+            case '"':
+                tok.type = GrammarTok_quoted;
+                for (int next = mStream.sgetc(); next != ch; next = mStream.sgetc()) {
+                    if (next == Traits::eof() || next == '\n') {
+                        return { GrammarTok_err, "Unterminated quoted symbol", mLine };
+                    }
+                    tok.text += (char)mStream.sbumpc();
+                }
+                mStream.sbumpc();
+                if (tok.text.empty()) {
+                    return { GrammarTok_err, "Empty quoted symbol", mLine };
+                }
+                return tok;
+        }
+
+        if (std::isalpha(ch) || ch == '_') {
+            tok.text = (char)ch;
+            while (isNameChar(mStream.sgetc())) {
+                tok.text += (char)mStream.sbumpc();
+            }
+            return tok;
+        }
+
+        if (LEXER_DEFAULT_OP_CHARS.find((char)ch) != std::string::npos) {
+            tok.type = GrammarTok_quoted;
+            tok.text = (char)ch;
+            return tok;
+        }
+
+        return { GrammarTok_err, "Unexpected character", mLine };
+    }
+}
+
+const GrammarLoader::GrammarTok& GrammarLoader::peek(size_t ahead) {
+    while (mLookahead.size() <= ahead) {
+        mLookahead.push_back(scan());
+    }
+    return mLookahead[ahead];
+}
+
+GrammarLoader::GrammarTok GrammarLoader::take() {
+    peek();
+    GrammarTok tok = std::move(mLookahead.front());
+    mLookahead.pop_front();
+    return tok;
+}
+
+uint32_t GrammarLoader::intern(const GrammarTok& tok) {
+    bool quoted = tok.type == GrammarTok_quoted;
+    std::string key = quoted ? "'" + tok.text : tok.text;
+
+    auto [it, inserted] = mNameIndex.try_emplace(std::move(key), (uint32_t)mNames.size());
+    if (inserted) {
+        mNames.push_back({tok.text, quoted});
+    }
+    return it->second;
+}
+
+int GrammarLoader::fail(const GrammarTok& tok, const char* message, GrammarLoadInfo& info) {
+    info.status = TKN_ERR;
+    info.line = tok.line;
+    info.message = tok.type == GrammarTok_err ? tok.text : message;
+    return TKN_ERR;
+}
+
+int GrammarLoader::declarePrecedence(const GrammarTok& directive, GrammarLoadInfo& info) {
+    PendingPrecedence decl { .line = directive.line };
+    if (directive.text == "left") {
+        decl.assoc = PrecAssoc_left;
+    } else if (directive.text == "right") {
+        decl.assoc = PrecAssoc_right;
+    } else if (directive.text == "nonassoc") {
+        decl.assoc = PrecAssoc_nonassoc;
+    } else {
+        return fail(directive, "Unknown directive", info);
+    }
+
+    while (true) {
+        const GrammarTok& tok = peek();
+        bool isSymbol = tok.type == GrammarTok_quoted || tok.type == GrammarTok_name;
+        if (!isSymbol || (tok.type == GrammarTok_name && peek(1).type == GrammarTok_arrow)) {
+            break;
+        }
+        decl.names.push_back(intern(take()));
+    }
+
+    if (peek().type == GrammarTok_semicolon) {
+        take();
+    }
+
+    if (decl.names.empty()) {
+        return fail(directive, "Precedence declaration without symbols", info);
+    }
+    mPrecedence.push_back(std::move(decl));
+    return TKN_OK;
+}
+
+int GrammarLoader::load(std::vector<TokRule>& rules, std::vector<PrecedenceDecl>& precedence, GrammarLoadInfo& info) {
+    info = {};
+    std::vector<PendingRule> pending;
+
+    while (peek().type != GrammarTok_end) {
+        if (peek().type == GrammarTok_directive) {
+            if (declarePrecedence(take(), info) != TKN_OK) {
+                return TKN_ERR;
+            }
+            continue;
+        }
+
+        GrammarTok lhs = take();
+        if (lhs.type != GrammarTok_name) {
+            return fail(lhs, "Expected a rule name", info);
+        }
+
+        GrammarTok arrow = take();
+        if (arrow.type != GrammarTok_arrow) {
+            return fail(arrow, "Expected '->'", info);
+        }
+
+        PendingRule rule { .lhs = intern(lhs) };
+        bool tagged = false;
+        bool closed = false;
+        bool ruleDone = false;
+
+        while (!ruleDone) {
+            const GrammarTok& tok = peek();
+
+            if (tok.type == GrammarTok_name && peek(1).type == GrammarTok_arrow) {
+                pending.push_back(std::move(rule));
+                break;
+            }
+
+            switch (tok.type) {
+                case GrammarTok_name:
+                case GrammarTok_quoted:
+                    if (closed) {
+                        return fail(tok, "Tags and %prec must end their alternative", info);
+                    }
+                    rule.rhs.push_back(intern(take()));
+                    break;
+
+                case GrammarTok_tag: {
+                    if (tagged) {
+                        return fail(tok, "Alternative has two tags", info);
+                    }
+
+                    GrammarTok tag = take();
+                    if (!std::isdigit((unsigned char)tag.text[0])) {
+                        rule.tag = mSymbols.addTag(tag.text);
+                    } else {
+                        const char* end = tag.text.data() + tag.text.size();
+                        auto [ptr, ec] = std::from_chars(tag.text.data(), end, rule.tag);
+                        if (ec != std::errc() || ptr != end) {
+                            return fail(tag, "Numeric tag is not a valid number", info);
+                        }
+                    }
+                    tagged = closed = true;
+                    break;
+                }
+
+                case GrammarTok_directive: {
+                    if (tok.text != "prec") {
+                        pending.push_back(std::move(rule));
+                        ruleDone = true;
+                        break;
+                    }
+
+                    GrammarTok directive = take();
+                    if (rule.prec != GrammarLoader_noName) {
+                        return fail(directive, "Alternative has two %prec", info);
+                    }
+
+                    GrammarTok symbol = take();
+                    if (symbol.type != GrammarTok_name && symbol.type != GrammarTok_quoted) {
+                        return fail(symbol, "Expected a terminal after %prec", info);
+                    }
+                    rule.prec = intern(symbol);
+                    closed = true;
+                    break;
+                }
+
+                case GrammarTok_bar:
+                    take();
+                    pending.push_back(rule);
+                    rule.rhs.clear();
+                    rule.tag = 0;
+                    rule.prec = GrammarLoader_noName;
+                    tagged = closed = false;
+                    break;
+
+                case GrammarTok_semicolon:
+                    take();
+                    pending.push_back(std::move(rule));
+                    ruleDone = true;
+                    break;
+
+                case GrammarTok_end:
+                    pending.push_back(std::move(rule));
+                    ruleDone = true;
+                    break;
+
+                default:
+                    return fail(tok, "Unexpected token", info);
+            }
+        }
+    }
+
+    if (pending.empty()) {
+        info = { TKN_ERR, mLine, "Grammar has no rules" };
+        return TKN_ERR;
+    }
+    return resolve(pending, rules, precedence, info);
+}
+
+int GrammarLoader::resolve(std::vector<PendingRule>& pending, std::vector<TokRule>& rules, std::vector<PrecedenceDecl>& precedence, GrammarLoadInfo& info) {
+    std::vector<bool> isLhs(mNames.size());
+    for (const PendingRule& rule : pending) {
+        isLhs[rule.lhs] = true;
+    }
+
+    std::vector<const TokenInfo*> infos(mNames.size());
+    for (uint32_t i = 0; i < mNames.size(); ++i) {
+        const GrammarSymbol* symbol = mSymbols.add(mNames[i].text, isLhs[i] ? TokenCategory_nonterm : TokenCategory_term);
+        if (!symbol) {
+            info = { TKN_ERR, mLine, "'" + mNames[i].text + "' is used both as a terminal and a nonterminal" };
+            return TKN_ERR;
+        }
+        infos[i] = &symbol->info;
+    }
+
+    precedence.clear();
+    for (const PendingPrecedence& decl : mPrecedence) {
+        PrecedenceDecl& resolved = precedence.emplace_back(PrecedenceDecl { .assoc = decl.assoc });
+        for (uint32_t name : decl.names) {
+            if (isLhs[name]) {
+                info = { TKN_ERR, decl.line, "Precedence declared for nonterminal '" + mNames[name].text + "'" };
+                return TKN_ERR;
+            }
+            resolved.terminals.push_back(infos[name]->id);
+        }
+    }
+
+    // Rule 0 is the augmented start rule the table builder accepts on.
+    const GrammarSymbol* start = mSymbols.add("$accept", TokenCategory_nonterm);
+    const TokenInfo* first = infos[pending.front().lhs];
+
+    rules.clear();
+    rules.reserve(pending.size() + 1);
+    rules.push_back(TokRule {
+        .lhs = Token(&start->info, start->name),
+        .rhs = { Token(first, first->value) }
+    });
+
+    for (const PendingRule& rule : pending) {
+        TokRule& tokRule = rules.emplace_back(TokRule {
+            .lhs = Token(infos[rule.lhs], infos[rule.lhs]->value),
+            .tag = rule.tag,
+            .prec = rule.prec == GrammarLoader_noName ? TKN_NO_ID : infos[rule.prec]->id
+        });
+
+        tokRule.rhs.reserve(rule.rhs.size());
+        for (uint32_t sym : rule.rhs) {
+            tokRule.rhs.emplace_back(infos[sym], infos[sym]->value);
+        }
+    }
+    return TKN_OK;
+}
@@ -0,0 +1,162 @@
+#ifndef GRAMMARLOADER_HPP
+#define GRAMMARLOADER_HPP
+
+#include "LexerBuilder.hpp"
+#include "ParserDefs.hpp"
+#include <deque>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct TokRule;
+
+constexpr TokenID GrammarSymbols_firstTerminal = 1 << 16;
+constexpr TokenID GrammarSymbols_firstNonterminal = 20000000;
+
+struct GrammarSymbol {
+    std::string name;
+    TokenInfo info;
+};
+
+// Dense table of the symbols and tags named by a grammar file. Terminals the
+// default lexer already knows keep its ids, everything else gets the next
+// free id of its category. Symbols never move once added, so rules can point
+// at their infos.
+class GrammarSymbols {
+public:
+    const GrammarSymbol* find(std::string_view name) const {
+        auto it = mIndex.find(std::string(name));
+        return it == mIndex.end() ? nullptr : &mSymbols[it->second];
+    }
+
+    const GrammarSymbol* add(std::string_view name, TokenID category);
+
+    RuleTag tag(std::string_view name) const {
+        auto it = mTags.find(std::string(name));
+        return it == mTags.end() ? 0 : it->second;
+    }
+
+    RuleTag addTag(std::string_view name);
+
+    size_t size() const {
+        return mSymbols.size();
+    }
+
+    const GrammarSymbol& operator[](size_t index) const {
+        return mSymbols[index];
+    }
+
+    // Registers the terminals that got new ids as static tokens, so that a
+    // lexer built from the builder returns them for their spelling.
+    LexerBuilder& addTerminals(LexerBuilder& builder) const;
+
+    void clear();
+private:
+    std::deque<GrammarSymbol> mSymbols;
+    std::unordered_map<std::string, uint32_t> mIndex;
+    std::unordered_map<std::string, RuleTag> mTags;
+    RuleTag mNextTag = 1;
+    TokenID mNextTerminal = GrammarSymbols_firstTerminal;
+    TokenID mNextNonterminal = GrammarSymbols_firstNonterminal;
+};
+
+struct PrecedenceDecl {
+    PrecAssoc_ assoc = PrecAssoc_left;
+    std::vector<TokenID> terminals;
+};
+
+struct GrammarLoadInfo {
+    int status = TKN_OK;
+    size_t line{};
+    LexerMsg message;
+};
+
+// Reads a grammar from a stream:
+//
+//     # comment
+//     expr -> expr '+' term @add | term
+//     term -> term "*" fact @mul
+//          | fact
+//     fact -> int | '(' expr ')' ;
+//
+// Names that appear on a left-hand side are nonterminals, the rest are
+// terminals. int, real and id name the default lexer's literals, operator
+// characters its operators, either bare or quoted. An empty alternative
+// derives epsilon. @name tags are numbered from 1 in order of appearance,
+// @N uses N as is; a file should use one kind or the other. The first
+// rule's left-hand side is the start symbol. The stream is read once,
+// character by character.
+//
+//     %left '+' '-'
+//     %left '*'
+//     %right NEG
+//     expr -> expr '+' expr @add | '-' expr %prec NEG @neg | int
+//
+// %left, %right and %nonassoc lines declare precedence levels, each line
+// binding tighter than the ones above it. %prec gives an alternative the
+// precedence of another terminal instead of its last one.
+class GrammarLoader {
+public:
+    GrammarLoader(std::istream& stream, GrammarSymbols& symbols)
+        : mStream(*stream.rdbuf()), mSymbols(symbols) { }
+
+    int load(std::vector<TokRule>& rules, std::vector<PrecedenceDecl>& precedence, GrammarLoadInfo& info);
+private:
+    enum GrammarTok_ {
+        GrammarTok_end,
+        GrammarTok_name,
+        GrammarTok_quoted,
+        GrammarTok_arrow,
+        GrammarTok_bar,
+        GrammarTok_semicolon,
+        GrammarTok_tag,
+        GrammarTok_directive,
+        GrammarTok_err
+    };
+
+    struct GrammarTok {
+        GrammarTok_ type = GrammarTok_end;
+        std::string text;
+        size_t line{};
+    };
+
+    static constexpr uint32_t GrammarLoader_noName = UINT32_MAX;
+
+    struct PendingRule {
+        uint32_t lhs{};
+        std::vector<uint32_t> rhs;
+        RuleTag tag{};
+        uint32_t prec = GrammarLoader_noName;
+    };
+
+    struct PendingPrecedence {
+        PrecAssoc_ assoc{};
+        std::vector<uint32_t> names;
+        size_t line{};
+    };
+
+    const GrammarTok& peek(size_t ahead = 0);
+    GrammarTok take();
+    GrammarTok scan();
+    uint32_t intern(const GrammarTok& tok);
+    int fail(const GrammarTok& tok, const char* message, GrammarLoadInfo& info);
+    int declarePrecedence(const GrammarTok& directive, GrammarLoadInfo& info);
+    int resolve(std::vector<PendingRule>& pending, std::vector<TokRule>& rules, std::vector<PrecedenceDecl>& precedence, GrammarLoadInfo& info);
+private:
+    std::streambuf& mStream;
+    GrammarSymbols& mSymbols;
+    size_t mLine = 1;
+    std::deque<GrammarTok> mLookahead;
+    std::vector<PendingPrecedence> mPrecedence;
+
+    struct Name {
+        std::string text;
+        bool quoted{};
+    };
+    std::vector<Name> mNames;
+    std::unordered_map<std::string, uint32_t> mNameIndex;
+};
+
+#endif
@@ -0,0 +1,142 @@
+#include "GrammarRegistry.hpp"
+#include "Tracer.hpp"
+#include <chrono>
+
+namespace {
+
+constexpr auto GrammarRegistry_reclaimInterval = std::chrono::milliseconds(50);
+
+bool hasTables(const ParserTables& tables) {
+    return !tables.rules.empty() && (!tables.actionTable.empty() || tables.compressed || tables.lazy);
+}
+
+}
+
+GrammarRegistry::GrammarRegistry() : GrammarRegistry(Parser()) { }
+
+GrammarRegistry::GrammarRegistry(const Parser& parser) : mTables(parser.getTables()) {
+    mWorker = std::thread([this] { work(); });
+}
+
+GrammarRegistry::~GrammarRegistry() {
+    {
+        std::lock_guard lock(mMutex);
+        mStop = true;
+    }
+    mWake.notify_one();
+    mWorker.join();
+}
+
+void GrammarRegistry::publish(std::shared_ptr<const ParserTables> tables) {
+    std::shared_ptr<const ParserTables> old = mTables.exchange(std::move(tables), std::memory_order_acq_rel);
+    mVersion.fetch_add(1, std::memory_order_release);
+
+    // Empty tables are shared by every default parser and never freed.
+    if (!hasTables(*old)) {
+        return;
+    }
+
+    {
+        std::lock_guard lock(mMutex);
+        mRetired.push_back(std::move(old));
+    }
+    mWake.notify_one();
+}
+
+void GrammarRegistry::reload(std::span<const StrRule> grammar, int flags) {
+    PendingGrammar pending { .flags = flags };
+    for (const StrRule& rule : grammar) {
+        pending.rules.push_back({rule.rule, rule.tag});
+    }
+
+    {
+        std::lock_guard lock(mMutex);
+        mPending = std::move(pending);
+    }
+    mWake.notify_one();
+}
+
+int GrammarRegistry::wait() {
+    std::unique_lock lock(mMutex);
+    mIdle.wait(lock, [this] {
+        return !mPending && !mBuilding;
+    });
+    return mLoadInfo.status;
+}
+
+void GrammarRegistry::waitRetired() {
+    std::unique_lock lock(mMutex);
+    mIdle.wait(lock, [this] {
+        return mRetired.empty();
+    });
+}
+
+void GrammarRegistry::work() {
+    std::unique_lock lock(mMutex);
+
+    while (true) {
+        auto wakeUp = [this] {
+            return mStop || mPending;
+        };
+        if (mRetired.empty()) {
+            mWake.wait(lock, wakeUp);
+        } else {
+            mWake.wait_for(lock, GrammarRegistry_reclaimInterval, wakeUp);
+        }
+
+        if (mStop) {
+            return;
+        }
+
+        // Retired tables are freed here once only this list still holds
+        // them, so the deallocation never lands on a request thread.
+        if (!mRetired.empty()) {
+            std::vector<std::shared_ptr<const ParserTables>> retired = std::move(mRetired);
+            mRetired.clear();
+            lock.unlock();
+            std::erase_if(retired, [](const std::shared_ptr<const ParserTables>& tables) {
+                return tables.use_count() == 1;
+            });
+            lock.lock();
+            mRetired.insert(mRetired.end(), retired.begin(), retired.end());
+            if (mRetired.empty()) {
+                mIdle.notify_all();
+            }
+        }
+
+        if (!mPending) {
+            continue;
+        }
+
+        // Only the latest request is built; reloads queued during a build
+        // replace each other.
+        PendingGrammar pending = std::move(*mPending);
+        mPending.reset();
+        mBuilding = true;
+        lock.unlock();
+
+        if (Tracer::enabled()) {
+            Tracer::nameThread("GrammarRegistry worker");
+        }
+        TraceScope trace("GrammarRegistry::reload", "builder");
+        std::vector<StrRule> rules;
+        for (const OwnedRule& rule : pending.rules) {
+            rules.push_back({rule.rule.c_str(), rule.tag});
+        }
+
+        ParserBuilder builder;
+        Parser parser = builder.initGrammarLexer().withFlags(pending.flags).loadGrammar(rules).build();
+        GrammarLoadInfo info = builder.getLoadInfo();
+        if (info.status == TKN_OK && !hasTables(*parser.getTables())) {
+            info = { TKN_ERR, 0, "Grammar yields no parse tables" };
+        }
+        if (info.status == TKN_OK) {
+            publish(parser.getTables());
+        }
+
+        lock.lock();
+        mLoadInfo = std::move(info);
+        mBuilding = false;
+        mIdle.notify_all();
+    }
+}
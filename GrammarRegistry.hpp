@@ -0,0 +1,83 @@
+#ifndef GRAMMARREGISTRY_HPP
+#define GRAMMARREGISTRY_HPP
+
+#include "ParserBuilder.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Holds the current tables of a grammar behind an atomic pointer. Requests
+// take a Parser over whatever tables are current; reload() rebuilds on a
+// background thread and swaps the pointer, so parses already running keep
+// the tables they started with. A reload whose grammar fails to load or
+// yields no tables keeps the current ones. Replaced tables are released by
+// the worker once no parser refers to them, never on a request thread.
+class GrammarRegistry {
+public:
+    GrammarRegistry();
+    explicit GrammarRegistry(const Parser& parser);
+    GrammarRegistry(const GrammarRegistry&) = delete;
+    ~GrammarRegistry();
+
+    Parser acquire() const {
+        return Parser(mTables.load(std::memory_order_acquire));
+    }
+
+    std::shared_ptr<const ParserTables> tables() const {
+        return mTables.load(std::memory_order_acquire);
+    }
+
+    size_t version() const {
+        return mVersion.load(std::memory_order_acquire);
+    }
+
+    void publish(std::shared_ptr<const ParserTables> tables);
+    void reload(std::span<const StrRule> grammar, int flags = ParserBuildFlags_none);
+
+    // Blocks until queued reloads are done and returns the status of the
+    // last one, TKN_OK or TKN_ERR.
+    int wait();
+
+    // Blocks until every replaced table is released, which a parser still
+    // holding one delays.
+    void waitRetired();
+
+    // Outcome of the last finished reload.
+    GrammarLoadInfo loadInfo() const {
+        std::lock_guard lock(mMutex);
+        return mLoadInfo;
+    }
+private:
+    struct OwnedRule {
+        std::string rule;
+        RuleTag tag{};
+    };
+
+    struct PendingGrammar {
+        std::vector<OwnedRule> rules;
+        int flags{};
+    };
+
+    void work();
+private:
+    std::atomic<std::shared_ptr<const ParserTables>> mTables;
+    std::atomic<size_t> mVersion{};
+
+    mutable std::mutex mMutex;
+    std::condition_variable mWake;
+    std::condition_variable mIdle;
+    std::optional<PendingGrammar> mPending;
+    std::vector<std::shared_ptr<const ParserTables>> mRetired;
+    GrammarLoadInfo mLoadInfo;
+    bool mBuilding = false;
+    bool mStop = false;
+    std::thread mWorker;
+};
+
+#endif
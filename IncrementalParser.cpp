@@ -0,0 +1,384 @@
+#include "IncrementalParser.hpp"
+#include "LexerSources.hpp"
+#include "Tracer.hpp"
+#include <algorithm>
+
+void IncrementalParser::cursorReset(Cursor& cursor) const {
+    cursor.clear();
+    if (mRoot != IncNode_none) {
+        cursor.push_back({mRoot, 0, 0});
+    }
+}
+
+bool IncrementalParser::cursorDescend(Cursor& cursor) const {
+    const IncNode& top = mNodes[cursor.back().node];
+    if (top.isLeaf() || top.childCount == 0) {
+        return false;
+    }
+
+    cursor.push_back({mChildren[top.firstChild], 0, cursor.back().start});
+    return true;
+}
+
+void IncrementalParser::cursorAdvance(Cursor& cursor) const {
+    while (!cursor.empty()) {
+        CursorFrame frame = cursor.back();
+        cursor.pop_back();
+
+        if (cursor.empty()) {
+            return;
+        }
+
+        const IncNode& parent = mNodes[cursor.back().node];
+        uint32_t next = frame.child + 1;
+        if (next < parent.childCount) {
+            cursor.push_back({mChildren[parent.firstChild + next], next, frame.start + mNodes[frame.node].length});
+            return;
+        }
+    }
+}
+
+bool IncrementalParser::cursorSeek(Cursor& cursor, size_t pos) const {
+    while (!cursor.empty()) {
+        const CursorFrame& frame = cursor.back();
+        size_t end = frame.start + mNodes[frame.node].length;
+
+        if (end <= pos) {
+            cursorAdvance(cursor);
+            continue;
+        }
+
+        if (frame.start == pos) {
+            return true;
+        }
+
+        if (frame.start > pos || !cursorDescend(cursor)) {
+            return false;
+        }
+    }
+    return false;
+}
+
+bool IncrementalParser::cursorSeekLeaf(Cursor& cursor, size_t pos) const {
+    while (!cursor.empty()) {
+        const CursorFrame& frame = cursor.back();
+        const IncNode& node = mNodes[frame.node];
+
+        if (frame.start + node.length < pos || (!node.isLeaf() && node.childCount == 0)) {
+            cursorAdvance(cursor);
+            continue;
+        }
+
+        if (node.isLeaf()) {
+            return true;
+        }
+        cursorDescend(cursor);
+    }
+    return false;
+}
+
+int IncrementalParser::lex(size_t from, size_t syncFrom, ptrdiff_t delta, Cursor* oldLeaves, std::vector<PendingToken>& tokens, ReparseRange& range) {
+    StringViewSource source(mText);
+    source.seek(from);
+
+    LexerResultInfo resultInfo;
+    size_t prevEnd = from;
+
+    range.relexStart = from;
+    range.delta = delta;
+    range.hitEnd = true;
+
+    while (true) {
+        Token tok;
+        int status = mLexer.next({
+            .token = tok,
+            .source = source,
+            .debug = resultInfo,
+        });
+
+        if (status == TKN_FINISH) {
+            break;
+        }
+
+        if (status != TKN_OK) {
+            return ParseStatus_err;
+        }
+
+        size_t end = source.tell();
+        tokens.push_back({tok.info(), tok.value(), end - prevEnd});
+        prevEnd = end;
+
+        if (!oldLeaves || end < syncFrom) {
+            continue;
+        }
+
+        // Once a new token ends where an old one did past the edit, the
+        // rest of the old token stream is unchanged.
+        size_t oldPos = (size_t)((ptrdiff_t)end - delta);
+        if (!cursorSeekLeaf(*oldLeaves, oldPos)) {
+            oldLeaves = nullptr;
+            continue;
+        }
+
+        const CursorFrame& leaf = oldLeaves->back();
+        if (leaf.start + mNodes[leaf.node].length == oldPos) {
+            range.hitEnd = false;
+            break;
+        }
+    }
+
+    mLexedTokens = tokens.size();
+    return ParseStatus_ok;
+}
+
+uint32_t IncrementalParser::addLeaf(ParserState state, const TokenInfo* info, TokenVal&& value, size_t length) {
+    IncNode leaf {
+        .symbol = info->id,
+        .lookahead = info->id,
+        .state = state,
+        .length = length,
+        .token = (uint32_t)mTokens.size()
+    };
+
+    mTokens.push_back({info, std::move(value)});
+    mNodes.push_back(leaf);
+    return mNodes.size() - 1;
+}
+
+bool IncrementalParser::reduce(ParserState ruleIndex) {
+    const GrammarRuleList& rules = mParser.getRules();
+    if (ruleIndex < 0 || ruleIndex >= (long long)rules.size()) {
+        return false;
+    }
+
+    const GrammarRule& rule = rules[ruleIndex];
+    if (rule.rhsSize > mNodeStack.size()) {
+        return false;
+    }
+
+    size_t base = mNodeStack.size() - rule.rhsSize;
+    IncNode node {
+        .symbol = rule.lhsId,
+        .lookahead = token_none,
+        .tag = rule.tag,
+        .childCount = (uint32_t)rule.rhsSize,
+        .firstChild = (uint32_t)mChildren.size()
+    };
+
+    for (size_t i = base; i < mNodeStack.size(); ++i) {
+        const IncNode& child = mNodes[mNodeStack[i]];
+        if (node.length == 0 && child.length != 0) {
+            node.lookahead = child.lookahead;
+        }
+        node.length += child.length;
+        mChildren.push_back(mNodeStack[i]);
+    }
+
+    mNodeStack.resize(base);
+    mStateStack.resize(mStateStack.size() - rule.rhsSize);
+    node.state = mStateStack.back();
+
+    ParserState next = ParserState_none;
+    if (!mParser.findGoto(node.state, rule.lhsId, next)) {
+        return false;
+    }
+
+    mNodes.push_back(node);
+    mNodeStack.push_back(mNodes.size() - 1);
+    mStateStack.push_back(next);
+    return true;
+}
+
+int IncrementalParser::reparse(std::vector<PendingToken>& tokens, const ReparseRange& range) {
+    enum Phase {
+        Phase_before,
+        Phase_relexed,
+        Phase_after
+    };
+
+    Cursor cursor;
+    cursorReset(cursor);
+
+    mStateStack.assign(1, mStartState);
+    mNodeStack.clear();
+    mReusedNodes = 0;
+
+    Phase phase = Phase_before;
+    size_t pos = 0;
+    size_t tokenIdx = 0;
+
+    while (true) {
+        uint32_t oldNode = IncNode_none;
+        bool atEnd = false;
+
+        if (phase == Phase_before && (pos >= range.relexStart || !cursorSeek(cursor, pos))) {
+            phase = Phase_relexed;
+        }
+
+        if (phase == Phase_relexed && tokenIdx >= tokens.size()) {
+            if (range.hitEnd) {
+                atEnd = true;
+            } else {
+                phase = Phase_after;
+            }
+        }
+
+        if (phase == Phase_after && !cursorSeek(cursor, (size_t)((ptrdiff_t)pos - range.delta))) {
+            atEnd = true;
+        }
+
+        if (!atEnd && phase != Phase_relexed) {
+            oldNode = cursor.back().node;
+        }
+
+        TokenID lookahead = token_lexer_end;
+        if (oldNode != IncNode_none) {
+            lookahead = mNodes[oldNode].lookahead;
+        } else if (!atEnd) {
+            lookahead = tokens[tokenIdx].info->id;
+        }
+
+        ParserState state = mStateStack.back();
+        Action action = mParser.findAction(state, lookahead);
+
+        if (action.type == ParserActType_reduce) {
+            if (!reduce(action.value)) {
+                break;
+            }
+            continue;
+        }
+
+        if (action.type == ParserActType_accept) {
+            mRoot = mNodeStack.size() == 1 ? mNodeStack.back() : IncNode_none;
+            if (mNodes.size() > 2 * mCompactedSize + 1024) {
+                compact();
+            }
+            return ParseStatus_finish;
+        }
+
+        if (action.type != ParserActType_shift) {
+            break;
+        }
+
+        if (oldNode != IncNode_none) {
+            const IncNode& node = mNodes[oldNode];
+
+            if (!node.isLeaf()) {
+                // The token after a subtree decides its last reductions, so
+                // only subtrees followed by an untouched token are reused.
+                bool untouched = phase == Phase_after || cursor.back().start + node.length < range.relexStart;
+                ParserState next = ParserState_none;
+                if (!untouched || node.state != state || !mParser.findGoto(state, node.symbol, next)) {
+                    cursorDescend(cursor);
+                    continue;
+                }
+
+                mStateStack.push_back(next);
+                ++mReusedNodes;
+            } else {
+                mStateStack.push_back(action.value);
+            }
+
+            mNodeStack.push_back(oldNode);
+            pos += node.length;
+            cursorAdvance(cursor);
+            continue;
+        }
+
+        PendingToken& tok = tokens[tokenIdx++];
+        mStateStack.push_back(action.value);
+        mNodeStack.push_back(addLeaf(state, tok.info, std::move(tok.value), tok.length));
+        pos += tok.length;
+    }
+
+    mRoot = IncNode_none;
+    return ParseStatus_err;
+}
+
+int IncrementalParser::parse(std::string text) {
+    TraceScope trace("IncrementalParser::parse", "parser");
+    mText = std::move(text);
+    mNodes.clear();
+    mChildren.clear();
+    mTokens.clear();
+    mRoot = IncNode_none;
+
+    std::vector<PendingToken> tokens;
+    ReparseRange range;
+    if (lex(0, 0, 0, nullptr, tokens, range) != ParseStatus_ok) {
+        return ParseStatus_err;
+    }
+
+    mCompactedSize = tokens.size() * 2;
+    return reparse(tokens, range);
+}
+
+int IncrementalParser::edit(size_t offset, size_t removed, std::string_view inserted) {
+    TraceScope trace("IncrementalParser::edit", "parser");
+    offset = std::min(offset, mText.size());
+    removed = std::min(removed, mText.size() - offset);
+
+    if (mRoot == IncNode_none) {
+        std::string text = mText;
+        text.replace(offset, removed, inserted);
+        return parse(std::move(text));
+    }
+
+    Cursor oldLeaves;
+    cursorReset(oldLeaves);
+
+    size_t relexStart = mNodes[mRoot].length;
+    if (cursorSeekLeaf(oldLeaves, offset)) {
+        relexStart = oldLeaves.back().start;
+    }
+
+    mText.replace(offset, removed, inserted);
+    ptrdiff_t delta = (ptrdiff_t)inserted.size() - (ptrdiff_t)removed;
+
+    std::vector<PendingToken> tokens;
+    ReparseRange range;
+    if (lex(relexStart, offset + inserted.size(), delta, &oldLeaves, tokens, range) != ParseStatus_ok) {
+        mRoot = IncNode_none;
+        return ParseStatus_err;
+    }
+    return reparse(tokens, range);
+}
+
+void IncrementalParser::compact() {
+    if (mRoot == IncNode_none) {
+        return;
+    }
+
+    std::vector<IncNode> nodes;
+    std::vector<uint32_t> children;
+    std::vector<IncToken> tokens;
+    nodes.push_back(mNodes[mRoot]);
+
+    std::vector<std::pair<uint32_t, uint32_t>> stack { {mRoot, 0} };
+    while (!stack.empty()) {
+        auto [oldIdx, newIdx] = stack.back();
+        stack.pop_back();
+
+        const IncNode& node = mNodes[oldIdx];
+        if (node.isLeaf()) {
+            nodes[newIdx].token = tokens.size();
+            tokens.push_back(std::move(mTokens[node.token]));
+            continue;
+        }
+
+        uint32_t first = children.size();
+        nodes[newIdx].firstChild = first;
+        for (uint32_t i = 0; i < node.childCount; ++i) {
+            uint32_t child = mChildren[node.firstChild + i];
+            children.push_back(nodes.size());
+            nodes.push_back(mNodes[child]);
+            stack.emplace_back(child, children.back());
+        }
+    }
+
+    mNodes = std::move(nodes);
+    mChildren = std::move(children);
+    mTokens = std::move(tokens);
+    mRoot = 0;
+    mCompactedSize = mNodes.size();
+}
@@ -0,0 +1,125 @@
+#ifndef INCREMENTALPARSER_HPP
+#define INCREMENTALPARSER_HPP
+
+#include "Parser.hpp"
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+constexpr uint32_t IncNode_none = UINT32_MAX;
+
+struct IncNode {
+    TokenID symbol{};               // token id for leaves, rule lhs otherwise
+    TokenID lookahead{};            // id of the first token covered
+    ParserState state{};            // LR state the node was shifted from
+    RuleTag tag{};
+    size_t length{};                // bytes covered, leading blanks included
+    uint32_t childCount{};
+    uint32_t firstChild = IncNode_none;
+    uint32_t token = IncNode_none;  // token pool index for leaves
+
+    bool isLeaf() const {
+        return token != IncNode_none;
+    }
+};
+
+struct IncToken {
+    const TokenInfo* info{};
+    TokenVal value;
+};
+
+// Keeps the tree of the last parse and, after an edit, relexes only the
+// damaged tokens and shifts unchanged subtrees as single symbols whenever
+// the LR state they were built from matches the current one.
+class IncrementalParser {
+public:
+    IncrementalParser(const Parser& parser, Lexer& lexer, ParserState startState = ParserState_none)
+        : mParser(parser), mLexer(lexer), mStartState(startState) { }
+
+    int parse(std::string text);
+    int edit(size_t offset, size_t removed, std::string_view inserted);
+    void compact();
+
+    const std::string& text() const {
+        return mText;
+    }
+
+    const IncNode* root() const {
+        return mRoot == IncNode_none ? nullptr : &mNodes[mRoot];
+    }
+
+    const IncNode& node(uint32_t index) const {
+        return mNodes[index];
+    }
+
+    std::span<const uint32_t> children(const IncNode& node) const {
+        if (node.isLeaf() || node.childCount == 0) {
+            return {};
+        }
+        return std::span<const uint32_t>(mChildren.data() + node.firstChild, node.childCount);
+    }
+
+    const IncToken& token(const IncNode& leaf) const {
+        return mTokens[leaf.token];
+    }
+
+    size_t reusedNodes() const {
+        return mReusedNodes;
+    }
+
+    size_t lexedTokens() const {
+        return mLexedTokens;
+    }
+private:
+    struct CursorFrame {
+        uint32_t node;
+        uint32_t child;
+        size_t start;
+    };
+    using Cursor = std::vector<CursorFrame>;
+
+    struct PendingToken {
+        const TokenInfo* info;
+        TokenVal value;
+        size_t length;
+    };
+
+    struct ReparseRange {
+        size_t relexStart{};
+        ptrdiff_t delta{};
+        bool hitEnd{};
+    };
+
+    void cursorReset(Cursor& cursor) const;
+    bool cursorDescend(Cursor& cursor) const;
+    void cursorAdvance(Cursor& cursor) const;
+    bool cursorSeek(Cursor& cursor, size_t pos) const;
+    bool cursorSeekLeaf(Cursor& cursor, size_t pos) const;
+
+    int lex(size_t from, size_t syncFrom, ptrdiff_t delta, Cursor* oldLeaves, std::vector<PendingToken>& tokens, ReparseRange& range);
+    int reparse(std::vector<PendingToken>& tokens, const ReparseRange& range);
+    uint32_t addLeaf(ParserState state, const TokenInfo* info, TokenVal&& value, size_t length);
+    bool reduce(ParserState ruleIndex);
+private:
+    const Parser& mParser;
+    Lexer& mLexer;
+    ParserState mStartState;
+
+    std::string mText;
+
+    std::vector<IncNode> mNodes;
+    std::vector<uint32_t> mChildren;
+    std::vector<IncToken> mTokens;
+    uint32_t mRoot = IncNode_none;
+    size_t mCompactedSize{};
+
+    ParserStateStack mStateStack;
+    std::vector<uint32_t> mNodeStack;
+
+    size_t mReusedNodes{};
+    size_t mLexedTokens{};
+};
+
+#endif
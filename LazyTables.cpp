@@ -0,0 +1,73 @@
+#include "LazyTables.hpp"
+#include "TerminalMasks.hpp"
+#include "Tracer.hpp"
+
+LazyTables::~LazyTables() = default;
+
+const LazyRow* LazyTables::materialize(ParserState state) {
+    std::lock_guard lock(mMutex);
+
+    std::atomic<Chunk*>& chunkSlot = mChunks[state >> LazyTables_chunkBits];
+    Chunk* chunk = chunkSlot.load(std::memory_order_relaxed);
+    if (!chunk) {
+        chunk = &mChunkStore.emplace_back();
+        chunkSlot.store(chunk, std::memory_order_release);
+    }
+
+    std::atomic<const LazyRow*>& rowSlot = chunk->rows[state & (LazyTables_chunkSize - 1)];
+    if (const LazyRow* row = rowSlot.load(std::memory_order_relaxed)) {
+        return row;
+    }
+
+    TraceScope trace("materializeRow", "builder");
+    LazyRow row;
+    if (!buildRow(state, row)) {
+        return nullptr;
+    }
+
+    LazyRow& published = mRows.emplace_back(std::move(row));
+    if (mTerminalMasks) {
+        size_t offset = appendTerminalMask(published.actions, published.expectedBits, published.expected);
+        published.expected.custom = published.expectedBits.data() + offset;
+    }
+
+    rowSlot.store(&published, std::memory_order_release);
+    mMaterialized.fetch_add(1, std::memory_order_relaxed);
+    return &published;
+}
+
+Action LazyTables::findAction(ParserState state, TokenID tokenId) {
+    const LazyRow* lazyRow = row(state);
+    if (!lazyRow) {
+        return {};
+    }
+
+    auto itAction = lazyRow->actions.find(tokenId);
+    if (itAction == lazyRow->actions.end()) {
+        return {};
+    }
+    return itAction->second;
+}
+
+bool LazyTables::findGoto(ParserState state, TokenID symbolId, ParserState& next) {
+    const LazyRow* lazyRow = row(state);
+    if (!lazyRow) {
+        return false;
+    }
+
+    auto itGoto = lazyRow->gotos.find(symbolId);
+    if (itGoto == lazyRow->gotos.end()) {
+        return false;
+    }
+    next = itGoto->second;
+    return true;
+}
+
+const TerminalMask* LazyTables::findExpected(ParserState state) {
+    if (!mTerminalMasks) {
+        return nullptr;
+    }
+
+    const LazyRow* lazyRow = row(state);
+    return lazyRow ? &lazyRow->expected : nullptr;
+}
@@ -0,0 +1,73 @@
+#ifndef LAZYTABLES_HPP
+#define LAZYTABLES_HPP
+
+#include "ParserDefs.hpp"
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct LazyRow {
+    std::unordered_map<TokenID, Action> actions;
+    std::unordered_map<TokenID, TokenID> gotos;
+    TerminalMask expected;
+    std::vector<uint64_t> expectedBits;
+};
+
+// Append-only store of parse table rows that are built the first time a
+// parse reaches their state. Published rows never change, so lookups read
+// them without locking; only a miss takes the mutex and builds the row.
+class LazyTables {
+public:
+    explicit LazyTables(bool terminalMasks = false) : mTerminalMasks(terminalMasks) { }
+    LazyTables(const LazyTables&) = delete;
+    virtual ~LazyTables();
+
+    Action findAction(ParserState state, TokenID tokenId);
+    bool findGoto(ParserState state, TokenID symbolId, ParserState& next);
+    const TerminalMask* findExpected(ParserState state);
+
+    size_t materializedStates() const {
+        return mMaterialized.load(std::memory_order_relaxed);
+    }
+protected:
+    // Called with the store locked; returns false for unknown states.
+    virtual bool buildRow(ParserState state, LazyRow& row) = 0;
+private:
+    const LazyRow* row(ParserState state) {
+        if (state < 0 || state >= LazyTables_maxStates) {
+            return nullptr;
+        }
+
+        Chunk* chunk = mChunks[state >> LazyTables_chunkBits].load(std::memory_order_acquire);
+        if (chunk) {
+            const LazyRow* row = chunk->rows[state & (LazyTables_chunkSize - 1)].load(std::memory_order_acquire);
+            if (row) {
+                return row;
+            }
+        }
+        return materialize(state);
+    }
+
+    const LazyRow* materialize(ParserState state);
+private:
+    static constexpr ParserState LazyTables_chunkBits = 10;
+    static constexpr ParserState LazyTables_chunkSize = 1 << LazyTables_chunkBits;
+    static constexpr ParserState LazyTables_maxChunks = 4096;
+    static constexpr ParserState LazyTables_maxStates = LazyTables_chunkSize * LazyTables_maxChunks;
+
+    struct Chunk {
+        std::atomic<const LazyRow*> rows[LazyTables_chunkSize] {};
+    };
+
+    std::atomic<Chunk*> mChunks[LazyTables_maxChunks] {};
+    std::deque<Chunk> mChunkStore;
+    std::deque<LazyRow> mRows;
+    std::mutex mMutex;
+    std::atomic<size_t> mMaterialized{};
+    bool mTerminalMasks{};
+};
+
+#endif
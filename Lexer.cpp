@@ -1,9 +1,13 @@
 #include "Lexer.hpp"
+#include "NumericLiterals.hpp"
+#include "ParseStats.hpp"
 
 Lexer& Lexer::operator=(Lexer&& lexer) {
 	mCheckers = std::move(lexer.mCheckers);
 	mDynamicTokens = std::move(lexer.mDynamicTokens);
 	mStaticTokens = std::move(lexer.mStaticTokens);
+	mOperators = std::move(lexer.mOperators);
+	mDecodeNumbers = lexer.mDecodeNumbers;
 	return *this;
 }
 
@@ -18,6 +22,7 @@ bool TokenSwitchArgs::setResultInfo(const char* name, bool isDyn) const {
 }
 
 int Lexer::callCheckers(const TokenSwitchArgs& args) {
+	LRPARSER_STAT(ParseStats::local().checkerCalls++);
 	auto& list = mCheckers[args.state];
 
 	for(auto& func : list) {
@@ -28,6 +33,7 @@ int Lexer::callCheckers(const TokenSwitchArgs& args) {
 			args.msg,
 			args.resultInfo,
 			args.ch,
+			args.expected,
 		});
 
 		if(status != TKN_OK) {
@@ -66,6 +72,7 @@ int Lexer::next(const LexerInputArgs& args) {
 		if(status == TKN_SKIP) {
 			source.nextChar(currCh);
 			skip = true;
+			LRPARSER_STAT(ParseStats::local().skips++);
 		}
 
 		if (skip) {
@@ -77,7 +84,12 @@ int Lexer::next(const LexerInputArgs& args) {
 			continue;
 		}
 
-		if(status == TKN_FINISH) {
+		if(status == TKN_MORE) {
+			return TKN_MORE;
+		}
+
+		bool atEnd = status == TKN_FINISH;
+		if(atEnd) {
 			currCh = '\0';
 			status = TKN_OK;
 		}
@@ -86,22 +98,38 @@ int Lexer::next(const LexerInputArgs& args) {
 			break;
 		}
 
-		int checkerStatus = callCheckers(TokenSwitchArgs {
-			this,
-			state,
-			result,
-			msg,
-			resultInfo,
-			currCh,
-		});
+		int checkerStatus = TKN_OK;
+		if (state == token_none && result.empty() && !atEnd && mOperators.starts(currCh)) {
+			checkerStatus = mOperators.match(source, args.expected, result, resultInfo);
+			if (checkerStatus == TKN_MORE) {
+				return TKN_MORE;
+			}
+			LRPARSER_STAT(ParseStats::local().lexerStateBytes.add(state, result.size()));
+			col += result.size();
+		} else {
+			checkerStatus = callCheckers(TokenSwitchArgs {
+				this,
+				state,
+				result,
+				msg,
+				resultInfo,
+				currCh,
+				args.expected,
+			});
+		}
 
 		if (checkerStatus == TKN_ERR) {
 			return TKN_ERR;
 		}
 
+		if(checkerStatus == TKN_SKIP && atEnd) {
+			return TKN_FINISH;
+		}
+
 		if(checkerStatus == TKN_SKIP) {
 			source.nextChar(currCh);
 			skip = true;
+			LRPARSER_STAT(ParseStats::local().skips++);
 		}
 
 		if (skip) {
@@ -123,6 +151,13 @@ int Lexer::next(const LexerInputArgs& args) {
 			}
 			
 			token = Token(resultInfo, result);
+			if (mDecodeNumbers && (resultInfo->id == token_integer || resultInfo->id == token_real)) {
+				long long integer = 0;
+				double number = 0;
+				token.setFlags(decodeNumber(result, resultInfo->id == token_real, integer, number));
+				token.setNumber(integer, number);
+			}
+			LRPARSER_STAT(ParseStats::local().tokens.add(resultInfo->id));
 			debug.col = col;
 			debug.line = line;
 			debug.curResult = std::move(result);
@@ -133,6 +168,7 @@ int Lexer::next(const LexerInputArgs& args) {
 		}
 
 		source.nextChar(currCh);
+		LRPARSER_STAT(ParseStats::local().lexerStateBytes.add(state));
 		++col;		
 		if (currCh == '\n') {
 			col = 0;
@@ -182,6 +218,11 @@ const TokenInfo* Lexer::addDynamic(const char* value, const TokenInfo& info) {
 	return &val;
 }
 
+const TokenInfo* Lexer::addOperator(const char* value, const TokenInfo& info) {
+	mOperators.add(value, info);
+	return addStatic(value, info);
+}
+
 const TokenInfo* Lexer::getStatic(const char* value) {
 	auto iter = mStaticTokens.find(value);
 	
@@ -2,14 +2,18 @@
 #define LEXER_HPP
 
 #include "LexerDefs.hpp"
+#include "OperatorTrie.hpp"
+#include <cstdint>
 #include <functional>
 #include <string>
 #include <unordered_map>
 #include <list>
+#include <memory_resource>
 
 constexpr int TKN_ERR = -1;
 constexpr int TKN_FINISH = -2;
 constexpr int TKN_SKIP = -3;
+constexpr int TKN_MORE = -4;
 constexpr int TKN_OK = 0;
 constexpr int TKN_NO_ID = 0;
 
@@ -34,6 +38,30 @@ struct LexerResultInfo {
 	LexerMsg message{};
 };
 
+// Terminals the parser can take next. Builtin token ids live in one word,
+// larger ids in a bit span that starts at base.
+struct TerminalMask {
+	uint64_t builtin{};
+	const uint64_t* custom{};
+	TokenID base{};
+	TokenID count{};
+
+	bool test(TokenID id) const {
+		if (id >= 0 && id < 64) {
+			return (builtin >> id) & 1;
+		}
+
+		TokenID offset = id - base;
+		return id >= 64 && offset >= 0 && offset < count && ((custom[offset >> 6] >> (offset & 63)) & 1);
+	}
+
+	// Whether anything beyond the builtin tokens, keywords included, is
+	// acceptable.
+	bool hasCustom() const {
+		return count > 0 || (builtin >> token_custom) != 0;
+	}
+};
+
 struct TokenSwitchArgs {
 	Lexer* lexer{};
 	TokenID& state;
@@ -41,6 +69,7 @@ struct TokenSwitchArgs {
 	LexerMsg& msg;
 	const TokenInfo*& resultInfo;
 	char ch;
+	const TerminalMask* expected{};
 
 	inline void setState(TokenID state) const {
 		this->state = state;
@@ -51,7 +80,7 @@ struct TokenSwitchArgs {
 
 using TokenSwitchFunc = int (*)(const TokenSwitchArgs& args);
 using TokenSwitch = std::function<int (const TokenSwitchArgs& args)>;
-using TokenCheckerMap = std::unordered_map<TokenID, std::list<TokenSwitch>>;
+using TokenCheckerMap = std::pmr::unordered_map<TokenID, std::pmr::list<TokenSwitch>>;
 
 class LexerSource {
 public:
@@ -62,7 +91,14 @@ public:
 	virtual bool seek(size_t pos) = 0;
 };
 
-using TokenMap = std::unordered_map<TokenVal, TokenInfo>;
+using TokenMap = std::pmr::unordered_map<TokenVal, TokenInfo>;
+
+enum TokenFlags_ {
+	TokenFlags_none = 0,
+	TokenFlags_number = 1 << 0,		// integer() and number() hold the decoded literal
+	TokenFlags_overflow = 1 << 1,	// the integer saturated or the real is infinite
+	TokenFlags_inexact = 1 << 2,	// more digits than number() keeps
+};
 
 struct Token {
 public:
@@ -88,10 +124,27 @@ public:
 		return mFlags;
 	}
 
+	// Set by a lexer with number decoding on, see TokenFlags_number. Reals
+	// leave integer() at 0.
+	long long integer() const {
+		return mInteger;
+	}
+
+	double number() const {
+		return mNumber;
+	}
+
+	void setNumber(long long integer, double number) {
+		mInteger = integer;
+		mNumber = number;
+	}
+
 private:
 	const TokenInfo* mInfo;
 	TokenVal mVal{};
 	size_t mFlags{};
+	long long mInteger{};
+	double mNumber{};
 };
 
 struct LexerInputArgs {
@@ -99,15 +152,20 @@ struct LexerInputArgs {
 	LexerSource& source; 
 	LexerResultInfo& debug;
 	int initState = token_none;
+	const TerminalMask* expected = nullptr;
 };
 
+// The checker and token maps allocate from the memory resource given at
+// construction, the default resource otherwise. Copies use the default one.
 class Lexer {
 public:
 	Lexer() = default;
+	explicit Lexer(std::pmr::memory_resource* resource)
+		: mCheckers(resource), mStaticTokens(resource), mDynamicTokens(resource) { }
 	Lexer(const Lexer& lexer) = default;
-	Lexer(Lexer&& lexer) {
-		operator=(std::move(lexer));
-	}
+	Lexer(Lexer&& lexer)
+		: mCheckers(std::move(lexer.mCheckers)), mStaticTokens(std::move(lexer.mStaticTokens)), mDynamicTokens(std::move(lexer.mDynamicTokens)),
+		mOperators(std::move(lexer.mOperators)), mDecodeNumbers(lexer.mDecodeNumbers) { }
 
 	Lexer& operator=(const Lexer& lexer) = default;
 	Lexer& operator=(Lexer&& lexer);
@@ -125,10 +183,29 @@ public:
 
 	const TokenInfo* getStatic(const char* value);
 	const TokenInfo* getDynamic(const char* value);
+
+	// An operator of any length, matched longest first from token_none
+	// before its checkers run.
+	const TokenInfo* addOperator(const char* value, const TokenInfo& info);
+
+	bool isOperatorStart(char ch) const {
+		return mOperators.starts(ch);
+	}
+
+	std::pmr::memory_resource* getMemoryResource() const {
+		return mCheckers.get_allocator().resource();
+	}
+
+	// Decode int and real tokens into Token::integer() and number().
+	void setNumberDecoding(bool decode) {
+		mDecodeNumbers = decode;
+	}
 private:
 	TokenCheckerMap mCheckers;
 	TokenMap mStaticTokens;
 	TokenMap mDynamicTokens;
+	OperatorTrie mOperators;
+	bool mDecodeNumbers{};
 };
 
 #endif
\ No newline at end of file
@@ -9,6 +9,11 @@ bool isOperator(char ch) {
 	return opChars.find(ch) != std::string::npos;
 }
 
+// Whitespace and operators, the trie's included, end a word or number.
+static bool isDelimiter(const TokenSwitchArgs& args) {
+	return isspace(args.ch) || iscntrl(args.ch) || isOperator(args.ch) || args.lexer->isOperatorStart(args.ch);
+}
+
 int lexer_def_start_switch(const TokenSwitchArgs& args) {
 	if (isspace(args.ch)) {
 		return TKN_SKIP;
@@ -35,24 +40,40 @@ int lexer_def_start_switch(const TokenSwitchArgs& args) {
 	} else {
 		args.setState(token_lexer_end);
 		args.setResultInfo(std::string(&args.ch, 1).c_str(), false);
+		if (args.expected && args.resultInfo && !args.expected->test(args.resultInfo->id)) {
+			return TKN_ERR;
+		}
 		return TKN_OK;
 	}
 	return TKN_OK;
 }
 
+// A keyword the parser cannot take here is an identifier, and when it takes
+// no keyword at all the static lookup is skipped.
+static void setSymbolResult(const TokenSwitchArgs& args) {
+	const TokenInfo* info = nullptr;
+	if (!args.expected || args.expected->hasCustom()) {
+		info = args.lexer->getStatic(args.tokVal.c_str());
+	}
+
+	if (info && args.expected && !args.expected->test(info->id)) {
+		info = nullptr;
+	}
+
+	if (info) {
+		args.resultInfo = info;
+	} else {
+		args.setResultInfo("id", true);
+	}
+}
+
 int lexer_def_symbol_switch(const TokenSwitchArgs& args) {    
 	if(isalnum(args.ch)) {
 		return TKN_OK;
 	}
 
-	if(isspace(args.ch) || iscntrl(args.ch) || isOperator(args.ch)) {	
-        const TokenInfo* info = args.lexer->getStatic(args.tokVal.c_str());
-
-        if (args.setResultInfo(args.tokVal.c_str(), false)) {
-            args.resultInfo = info;
-        } else {
-            args.setResultInfo("id", true);
-        }
+	if(isDelimiter(args)) {	
+		setSymbolResult(args);
 		return TKN_FINISH;
 	}
 	return TKN_OK;
@@ -61,13 +82,7 @@ int lexer_def_symbol_switch(const TokenSwitchArgs& args) {
 int lexer_any_visible_switch(const TokenSwitchArgs& args) {
     bool isBlank = isspace(args.ch) || iscntrl(args.ch) || isblank(args.ch);
     if(args.tokVal.size() && isBlank) {	
-	    const TokenInfo* info = args.lexer->getStatic(args.tokVal.c_str());
-
-        if (args.setResultInfo(args.tokVal.c_str(), false)) {
-            args.resultInfo = info;
-        } else {
-            args.setResultInfo("id", true);
-        }	
+        setSymbolResult(args);
         return TKN_FINISH;
     }
 
@@ -95,7 +110,7 @@ int lexer_def_integer_switch(const TokenSwitchArgs& args) {
         return TKN_OK;
     }
 
-	if(isspace(args.ch) || iscntrl(args.ch) || isOperator(args.ch)) {
+	if(isDelimiter(args)) {
 		args.setResultInfo("int", true);
 		return TKN_FINISH;
 	}
@@ -108,7 +123,7 @@ int lexer_def_real_switch(const TokenSwitchArgs& args) {
 		return TKN_OK;
 	}
 
-	if(isspace(args.ch) || iscntrl(args.ch) || isOperator(args.ch)) {
+	if(isDelimiter(args)) {
 		args.setResultInfo("real", true);
 		return TKN_FINISH;
 	}
@@ -45,14 +45,16 @@ int lexer_any_visible_switch(const TokenSwitchArgs& args);
 class LexerBuilder {
 public:
     LexerBuilder() = default;
+    explicit LexerBuilder(std::pmr::memory_resource* resource) : mLexer(resource) { }
 
     LexerBuilder& addState(int state, TokenSwitchFunc func) {
         mLexer.addSwitch(state, func);
         return *this;
     }
 
+    // Operators of any length, e.g. "==" or ">>=", matched longest first.
     LexerBuilder& addOperator(const std::string& op, int id) {
-        mLexer.addStatic(op.c_str(), { .id = (int)id });
+        mLexer.addOperator(op.c_str(), { .id = (int)id });
         return *this;
     }
 
@@ -88,11 +90,16 @@ public:
     LexerBuilder& withStandardOperators() {
         for (size_t i = 0; i < LEXER_DEFAULT_OP_CHARS.size(); ++i) {
             std::string op(1, LEXER_DEFAULT_OP_CHARS[i]);
-            mLexer.addStatic(op.c_str(), { .id = LEXER_DEFAULT_OP_IDS[i] });
+            mLexer.addOperator(op.c_str(), { .id = LEXER_DEFAULT_OP_IDS[i] });
         }
         return *this;
     }
 
+    LexerBuilder& withNumberDecoding() {
+        mLexer.setNumberDecoding(true);
+        return *this;
+    }
+
     Lexer build() {
         return std::move(mLexer);
     }
@@ -38,6 +38,7 @@ enum TokenStates {
     token_op,
     token_any,
     token_new_line,
+    token_custom,
 };
 
 enum TokenCategory {
@@ -1,6 +1,7 @@
 #include "LexerSources.hpp"
 
-int StringSource::peekChar(char& ch) {
+template <typename Str>
+int BasicStringSource<Str>::peekChar(char& ch) {
 	if(mPos >= mStr.size()) {
 		return TKN_FINISH;
 	}
@@ -9,7 +10,8 @@ int StringSource::peekChar(char& ch) {
 	return TKN_OK;
 }
 
-int StringSource::nextChar(char& ch) {
+template <typename Str>
+int BasicStringSource<Str>::nextChar(char& ch) {
 	if(mPos >= mStr.size()) {
 		return TKN_FINISH;
 	}
@@ -20,14 +22,73 @@ int StringSource::nextChar(char& ch) {
 	return TKN_OK;
 }
 
-size_t StringSource::tell() const {
+template <typename Str>
+size_t BasicStringSource<Str>::tell() const {
 	return mPos;
 }
 
-bool StringSource::seek(size_t pos) {
+template <typename Str>
+bool BasicStringSource<Str>::seek(size_t pos) {
 	if (pos > mStr.size()) {
 		pos = mStr.size();
 	}
 	mPos = pos;
 	return true;
+}
+
+template class BasicStringSource<std::string>;
+template class BasicStringSource<std::string_view>;
+
+void ChunkSource::append(std::span<const char> data) {
+	mBuf.append(data.data(), data.size());
+}
+
+void ChunkSource::close() {
+	mClosed = true;
+}
+
+void ChunkSource::discard() {
+	size_t consumed = mPos - mBase;
+	if (consumed == 0 || consumed < mBuf.size() / 2) {
+		return;
+	}
+
+	mBuf.erase(0, consumed);
+	mBase = mPos;
+}
+
+int ChunkSource::peekChar(char& ch) {
+	if(mPos - mBase >= mBuf.size()) {
+		return mClosed ? TKN_FINISH : TKN_MORE;
+	}
+
+	ch = mBuf[mPos - mBase];
+	return TKN_OK;
+}
+
+int ChunkSource::nextChar(char& ch) {
+	if(mPos - mBase >= mBuf.size()) {
+		return mClosed ? TKN_FINISH : TKN_MORE;
+	}
+
+	ch = mBuf[mPos - mBase];
+	++mPos;
+
+	return TKN_OK;
+}
+
+size_t ChunkSource::tell() const {
+	return mPos;
+}
+
+bool ChunkSource::seek(size_t pos) {
+	if (pos < mBase) {
+		return false;
+	}
+
+	if (pos > mBase + mBuf.size()) {
+		pos = mBase + mBuf.size();
+	}
+	mPos = pos;
+	return true;
 }
\ No newline at end of file
@@ -2,12 +2,16 @@
 #define LEXERSOURCES_HPP
 
 #include "Lexer.hpp"
+#include <span>
+#include <string>
+#include <string_view>
 
-class StringSource : public LexerSource {
+// Source over a whole string. StringSource keeps its own copy;
+// StringViewSource reads text that must outlive it.
+template <typename Str>
+class BasicStringSource : public LexerSource {
 public:
-	StringSource(const char* val) : mStr(val) { }
-	StringSource(const std::string& val) : mStr(val) { }
-	StringSource(std::string&& val) : mStr(std::move(val)) { }
+	BasicStringSource(Str val) : mStr(std::move(val)) { }
 
 	int peekChar(char& ch) override;
 	int nextChar(char& ch) override;
@@ -15,7 +19,36 @@ public:
 	bool seek(size_t pos) override;
 private:
 	size_t mPos = 0;
-	std::string mStr;
+	Str mStr;
+};
+
+using StringSource = BasicStringSource<std::string>;
+using StringViewSource = BasicStringSource<std::string_view>;
+
+extern template class BasicStringSource<std::string>;
+extern template class BasicStringSource<std::string_view>;
+
+class ChunkSource : public LexerSource {
+public:
+	ChunkSource() = default;
+
+	void append(std::span<const char> data);
+	void close();
+	void discard();
+
+	bool closed() const {
+		return mClosed;
+	}
+
+	int peekChar(char& ch) override;
+	int nextChar(char& ch) override;
+	size_t tell() const override;
+	bool seek(size_t pos) override;
+private:
+	size_t mBase = 0;
+	size_t mPos = 0;
+	bool mClosed = false;
+	std::string mBuf;
 };
 
 #endif
\ No newline at end of file
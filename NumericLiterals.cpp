@@ -0,0 +1,159 @@
+#include "NumericLiterals.hpp"
+#include "Lexer.hpp"
+#include <bit>
+#include <charconv>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+// A uint64_t holds any 19 digits.
+constexpr int NumericLiterals_maxDigits = 19;
+constexpr int NumericLiterals_doubleDigits = 17;
+constexpr uint64_t NumericLiterals_exactMantissa = 1ull << 53;
+
+constexpr double exactPowers[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+struct DigitScan {
+    uint64_t mantissa{};
+    int digits{};       // significant digits in the mantissa
+    int dropped{};      // significant digits that did not fit
+};
+
+bool isEightDigits(uint64_t chunk) {
+    return (chunk & 0xF0F0F0F0F0F0F0F0) == 0x3030303030303030
+        && ((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) == 0x3030303030303030;
+}
+
+// Little-endian chunk of eight digits to its value: adjacent digits are
+// combined into pairs, then the pairs into the two halves in one multiply.
+uint32_t eightDigitsValue(uint64_t chunk) {
+    constexpr uint64_t mask = 0x000000FF000000FF;
+    constexpr uint64_t mul1 = 100 + (1000000ull << 32);
+    constexpr uint64_t mul2 = 1 + (10000ull << 32);
+
+    chunk -= 0x3030303030303030;
+    chunk = chunk * 10 + (chunk >> 8);
+    return (uint32_t)(((chunk & mask) * mul1 + ((chunk >> 16) & mask) * mul2) >> 32);
+}
+
+// Appends the digits in [p, end) to the scan. kept is how many of them
+// the mantissa accounts for, leading zeros included.
+bool scanDigits(const char* p, const char* end, DigitScan& scan, size_t& kept) {
+    const char* begin = p;
+    if (!scan.mantissa) {
+        while (p < end && *p == '0') {
+            ++p;
+        }
+    }
+
+    if constexpr (std::endian::native == std::endian::little) {
+        while (end - p >= 8 && scan.digits + 8 <= NumericLiterals_maxDigits) {
+            uint64_t chunk;
+            std::memcpy(&chunk, p, sizeof(chunk));
+            if (!isEightDigits(chunk)) {
+                break;
+            }
+            scan.mantissa = scan.mantissa * 100000000 + eightDigitsValue(chunk);
+            scan.digits += 8;
+            p += 8;
+        }
+    }
+
+    for (; p < end && scan.digits < NumericLiterals_maxDigits; ++p) {
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        scan.mantissa = scan.mantissa * 10 + (*p - '0');
+        ++scan.digits;
+    }
+    kept = p - begin;
+
+    for (; p < end; ++p) {
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        ++scan.dropped;
+    }
+    return true;
+}
+
+double parseDouble(std::string_view text, size_t& flags) {
+    double value = 0;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec == std::errc::result_out_of_range) {
+        bool large = text.find_first_not_of("0.") < text.find('.');
+        value = large ? HUGE_VAL : 0.0;
+        flags |= large ? TokenFlags_overflow : TokenFlags_inexact;
+    }
+    return value;
+}
+
+size_t decodeInteger(std::string_view text, long long& integer, double& number) {
+    DigitScan scan;
+    size_t kept = 0;
+    if (text.empty() || !scanDigits(text.data(), text.data() + text.size(), scan, kept)) {
+        return TokenFlags_none;
+    }
+
+    size_t flags = TokenFlags_number;
+    if (scan.dropped || scan.mantissa > (uint64_t)LLONG_MAX) {
+        flags |= TokenFlags_overflow;
+        integer = LLONG_MAX;
+        number = parseDouble(text, flags);
+    } else {
+        integer = (long long)scan.mantissa;
+        number = (double)scan.mantissa;
+    }
+
+    if (scan.dropped || scan.mantissa > NumericLiterals_exactMantissa) {
+        flags |= TokenFlags_inexact;
+    }
+    return flags;
+}
+
+size_t decodeReal(std::string_view text, double& number) {
+    size_t dot = text.find('.');
+    std::string_view whole = text.substr(0, dot);
+    std::string_view fraction = dot == std::string_view::npos ? std::string_view() : text.substr(dot + 1);
+    while (!fraction.empty() && fraction.back() == '0') {
+        fraction.remove_suffix(1);
+    }
+
+    DigitScan scan;
+    size_t keptWhole = 0;
+    size_t keptFraction = 0;
+    if (text.empty()
+        || !scanDigits(whole.data(), whole.data() + whole.size(), scan, keptWhole)
+        || !scanDigits(fraction.data(), fraction.data() + fraction.size(), scan, keptFraction)) {
+        return TokenFlags_none;
+    }
+
+    size_t flags = TokenFlags_number;
+    if (!scan.dropped && scan.mantissa <= NumericLiterals_exactMantissa && keptFraction < std::size(exactPowers)) {
+        // Both operands are exact, so the one division rounds correctly.
+        number = (double)scan.mantissa / exactPowers[keptFraction];
+    } else {
+        number = parseDouble(text, flags);
+    }
+
+    if (scan.digits + scan.dropped > NumericLiterals_doubleDigits) {
+        flags |= TokenFlags_inexact;
+    }
+    return flags;
+}
+
+}
+
+size_t decodeNumber(std::string_view text, bool isReal, long long& integer, double& number) {
+    if (isReal) {
+        integer = 0;
+        return decodeReal(text, number);
+    }
+    return decodeInteger(text, integer, number);
+}
@@ -0,0 +1,14 @@
+#ifndef NUMERICLITERALS_HPP
+#define NUMERICLITERALS_HPP
+
+#include <cstddef>
+#include <string_view>
+
+// Decodes an integer literal, or a real one of the form digits '.' digits,
+// into integer and number. Digits are accumulated eight at a time. Reals
+// whose digits fit in 53 bits with at most 22 fraction digits take
+// Clinger's exact path, the rest go through std::from_chars; both round
+// correctly. Returns TokenFlags_ bits.
+size_t decodeNumber(std::string_view text, bool isReal, long long& integer, double& number);
+
+#endif
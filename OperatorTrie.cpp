@@ -0,0 +1,86 @@
+#include "OperatorTrie.hpp"
+#include "Lexer.hpp"
+
+void OperatorTrie::add(std::string_view op, const TokenInfo& info) {
+    if (op.empty()) {
+        return;
+    }
+
+    uint32_t& root = mFirst[(unsigned char)op.front()];
+    if (!root) {
+        mNodes.emplace_back();
+        root = (uint32_t)mNodes.size();
+    }
+
+    int32_t node = (int32_t)root - 1;
+    for (char ch : op.substr(1)) {
+        int32_t next = child(node, ch);
+        if (next < 0) {
+            next = (int32_t)mNodes.size();
+            mNodes[node].edges.emplace_back(ch, next);
+            mNodes.emplace_back();
+        }
+        node = next;
+    }
+
+    if (mNodes[node].info < 0) {
+        mNodes[node].info = (int32_t)mInfos.size();
+        mInfos.push_back(info);
+    } else {
+        mInfos[mNodes[node].info] = info;
+    }
+}
+
+int32_t OperatorTrie::child(int32_t node, char ch) const {
+    for (auto& [edge, next] : mNodes[node].edges) {
+        if (edge == ch) {
+            return next;
+        }
+    }
+    return -1;
+}
+
+int OperatorTrie::match(LexerSource& source, const TerminalMask* expected, std::string& text, const TokenInfo*& info) const {
+    size_t start = source.tell();
+    size_t bestLength = 0;
+    const TokenInfo* best = nullptr;
+
+    char ch = 0;
+    if (source.peekChar(ch) != TKN_OK) {
+        return TKN_ERR;
+    }
+
+    int32_t node = (int32_t)mFirst[(unsigned char)ch] - 1;
+    while (node >= 0) {
+        source.nextChar(ch);
+        text += ch;
+
+        const Node& current = mNodes[node];
+        if (current.info >= 0 && (!expected || expected->test(mInfos[current.info].id))) {
+            best = &mInfos[current.info];
+            bestLength = text.size();
+        }
+        // Like a checker-built token, the match waits for the character
+        // after it even when no longer operator can follow.
+        int status = source.peekChar(ch);
+        if (status == TKN_MORE) {
+            return TKN_MORE;
+        }
+        if (status != TKN_OK) {
+            break;
+        }
+        node = child(node, ch);
+    }
+
+    if (!best) {
+        source.seek(start);
+        return TKN_ERR;
+    }
+
+    if (bestLength < text.size()) {
+        source.seek(start + bestLength);
+        text.resize(bestLength);
+    }
+    info = best;
+    return TKN_FINISH;
+}
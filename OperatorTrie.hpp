@@ -0,0 +1,48 @@
+#ifndef OPERATORTRIE_HPP
+#define OPERATORTRIE_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+struct TokenInfo;
+struct TerminalMask;
+class LexerSource;
+
+// Operators of any length, matched longest first. The first byte indexes a
+// table of root nodes and later bytes follow a node's few edges, so a match
+// costs O(length). A longer candidate that fails part way is backed out of
+// with LexerSource::seek. Infos move when operators are added, so the trie
+// is filled before lexing starts.
+class OperatorTrie {
+public:
+    void add(std::string_view op, const TokenInfo& info);
+
+    bool starts(char ch) const {
+        return mFirst[(unsigned char)ch] != 0;
+    }
+
+    bool empty() const {
+        return mNodes.empty();
+    }
+
+    // Reads the longest operator the mask accepts, if given, into text and
+    // info. TKN_FINISH on a match, TKN_ERR without one, TKN_MORE when the
+    // source runs dry before the match is decided.
+    int match(LexerSource& source, const TerminalMask* expected, std::string& text, const TokenInfo*& info) const;
+private:
+    struct Node {
+        int32_t info = -1;
+        std::vector<std::pair<char, int32_t>> edges;
+    };
+
+    int32_t child(int32_t node, char ch) const;
+private:
+    uint32_t mFirst[256] {};    // root node + 1, 0 for none
+    std::vector<Node> mNodes;
+    std::vector<TokenInfo> mInfos;
+};
+
+#endif
@@ -0,0 +1,163 @@
+#include "ParsePipeline.hpp"
+#include "Tracer.hpp"
+#include <thread>
+
+class ParsePipeline::EventCollector {
+public:
+    EventCollector(ParsePipeline& pipeline, SpscRing<EventBatch>& ring) : mPipeline(pipeline), mRing(ring) {
+        mBatch.events.reserve(mPipeline.mOptions.batchSize);
+    }
+
+    int pushTerm(const Token& token) {
+        mBatch.events.push_back({nullptr, token});
+        flushIfFull();
+        return 0;
+    }
+
+    bool pushReduced(const GrammarRule& rule) {
+        mBatch.events.push_back({&rule, Token()});
+        flushIfFull();
+        return true;
+    }
+
+    bool flush(int status) {
+        mBatch.status = status;
+        bool pushed = mPipeline.push(mRing, std::move(mBatch));
+        mBatch = EventBatch {};
+        mBatch.events.reserve(mPipeline.mOptions.batchSize);
+        return pushed;
+    }
+private:
+    void flushIfFull() {
+        if (mBatch.events.size() >= mPipeline.mOptions.batchSize) {
+            flush(ParseStatus_ok);
+        }
+    }
+private:
+    ParsePipeline& mPipeline;
+    SpscRing<EventBatch>& mRing;
+    EventBatch mBatch;
+};
+
+template <typename T>
+bool ParsePipeline::push(SpscRing<T>& ring, T&& value) {
+    while (!ring.tryPush(std::move(value))) {
+        if (mStop.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+template <typename T>
+bool ParsePipeline::pop(SpscRing<T>& ring, T& value) {
+    while (!ring.tryPop(value)) {
+        if (mStop.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+void ParsePipeline::lexStage(LexerSource& source, SpscRing<TokenBatch>& tokens) {
+    if (Tracer::enabled()) {
+        Tracer::nameThread("ParsePipeline lexer");
+    }
+    TraceScope trace("lexStage", "lexer");
+    LexerResultInfo resultInfo;
+    TokenBatch batch;
+    batch.tokens.reserve(mOptions.batchSize);
+
+    while (true) {
+        Token token;
+        int status = mLexer.next({
+            .token = token,
+            .source = source,
+            .debug = resultInfo,
+        });
+
+        if (status != TKN_OK) {
+            batch.status = status == TKN_FINISH ? ParseStatus_finish : ParseStatus_err;
+            push(tokens, std::move(batch));
+            return;
+        }
+
+        batch.tokens.push_back(std::move(token));
+        if (batch.tokens.size() >= mOptions.batchSize) {
+            if (!push(tokens, std::move(batch))) {
+                return;
+            }
+            batch = TokenBatch {};
+            batch.tokens.reserve(mOptions.batchSize);
+        }
+    }
+}
+
+void ParsePipeline::parseStage(SpscRing<TokenBatch>& tokens, SpscRing<EventBatch>& events, ParserState startState) {
+    if (Tracer::enabled()) {
+        Tracer::nameThread("ParsePipeline parser");
+    }
+    TraceScope trace("parseStage", "parser");
+    EventCollector collector(*this, events);
+    TokenBatch batch;
+
+    while (pop(tokens, batch)) {
+        for (const Token& token : batch.tokens) {
+            int status = mParser.feedToken(token, collector, startState);
+            if (status != ParseStatus_ok) {
+                collector.flush(status == ParseStatus_finish ? ParseStatus_err : status);
+                return;
+            }
+        }
+
+        if (batch.status == ParseStatus_err) {
+            collector.flush(ParseStatus_err);
+            return;
+        }
+
+        if (batch.status == ParseStatus_finish) {
+            int status = mParser.feedToken(Token(), collector, startState);
+            collector.flush(status == ParseStatus_finish ? ParseStatus_finish : ParseStatus_err);
+            return;
+        }
+    }
+}
+
+int ParsePipeline::run(LexerSource& source, ParserValueStack& valueStack, ParserState startState) {
+    SpscRing<TokenBatch> tokens(mOptions.ringCapacity);
+    SpscRing<EventBatch> events(mOptions.ringCapacity);
+
+    mStop.store(false);
+    mParser.reset();
+
+    std::thread lexThread([&] {
+        lexStage(source, tokens);
+    });
+    std::thread parseThread([&] {
+        parseStage(tokens, events, startState);
+    });
+
+    int status = ParseStatus_err;
+    EventBatch batch;
+    while (pop(events, batch)) {
+        for (const ParseEvent& event : batch.events) {
+            if (event.rule) {
+                valueStack.pushReduced(*event.rule);
+            } else {
+                valueStack.pushTerm(event.token);
+            }
+        }
+
+        if (batch.status != ParseStatus_ok) {
+            status = batch.status;
+            break;
+        }
+    }
+
+    mStop.store(true);
+    lexThread.join();
+    parseThread.join();
+    return status;
+}
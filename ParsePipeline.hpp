@@ -0,0 +1,56 @@
+#ifndef PARSEPIPELINE_HPP
+#define PARSEPIPELINE_HPP
+
+#include "Parser.hpp"
+#include "SpscRing.hpp"
+#include <atomic>
+#include <vector>
+
+struct PipelineOptions {
+    size_t batchSize = 256;
+    size_t ringCapacity = 64;
+};
+
+// Runs lexing, LR driving and semantic actions as three stages: the lexer and
+// the parser each get a worker thread, the value stack runs on the caller.
+// Stages exchange batches through SPSC rings.
+class ParsePipeline {
+public:
+    ParsePipeline(const Parser& parser, Lexer& lexer, PipelineOptions options = {})
+        : mParser(parser), mLexer(lexer), mOptions(options) { }
+
+    int run(LexerSource& source, ParserValueStack& valueStack, ParserState startState = ParserState_none);
+private:
+    struct TokenBatch {
+        std::vector<Token> tokens;
+        int status = ParseStatus_ok;
+    };
+
+    struct ParseEvent {
+        const GrammarRule* rule{};
+        Token token;
+    };
+
+    struct EventBatch {
+        std::vector<ParseEvent> events;
+        int status = ParseStatus_ok;
+    };
+
+    class EventCollector;
+
+    void lexStage(LexerSource& source, SpscRing<TokenBatch>& tokens);
+    void parseStage(SpscRing<TokenBatch>& tokens, SpscRing<EventBatch>& events, ParserState startState);
+
+    template <typename T>
+    bool push(SpscRing<T>& ring, T&& value);
+
+    template <typename T>
+    bool pop(SpscRing<T>& ring, T& value);
+private:
+    Parser mParser;
+    Lexer& mLexer;
+    PipelineOptions mOptions;
+    std::atomic<bool> mStop{};
+};
+
+#endif
@@ -0,0 +1,67 @@
+#include "ParseSession.hpp"
+#include "Tracer.hpp"
+
+int ParseSession::feed(std::span<const char> data) {
+    if (mStatus == FeedStatus_done || mStatus == FeedStatus_err) {
+        return mStatus;
+    }
+
+    mSource.append(data);
+    mStatus = run();
+    return mStatus;
+}
+
+int ParseSession::finish() {
+    if (mStatus == FeedStatus_done || mStatus == FeedStatus_err) {
+        return mStatus;
+    }
+
+    mSource.close();
+    mStatus = run();
+    if (mStatus != FeedStatus_done) {
+        mStatus = FeedStatus_err;
+    }
+    return mStatus;
+}
+
+int ParseSession::run() {
+    TraceScope trace("ParseSession::run", "parser");
+    bool progressed = false;
+
+    while (true) {
+        size_t mark = mSource.tell();
+        Token tok;
+
+        int status = mLexer.next({
+            .token = tok,
+            .source = mSource,
+            .debug = mResultInfo,
+        });
+
+        if (status == TKN_MORE) {
+            mSource.seek(mark);
+            mSource.discard();
+            return progressed ? FeedStatus_progress : FeedStatus_needMore;
+        }
+
+        if (status == TKN_ERR) {
+            return FeedStatus_err;
+        }
+
+        if (status == TKN_FINISH) {
+            tok = Token();
+        }
+
+        int parseStatus = mParser.feedToken(tok, mValueStack, mStartState);
+        if (parseStatus == ParseStatus_finish) {
+            return FeedStatus_done;
+        }
+
+        if (parseStatus != ParseStatus_ok || status == TKN_FINISH) {
+            return FeedStatus_err;
+        }
+
+        progressed = true;
+        mSource.discard();
+    }
+}
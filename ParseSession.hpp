@@ -0,0 +1,46 @@
+#ifndef PARSESESSION_HPP
+#define PARSESESSION_HPP
+
+#include "LexerSources.hpp"
+#include "Parser.hpp"
+#include <span>
+
+enum FeedStatus_ {
+    FeedStatus_needMore,
+    FeedStatus_progress,
+    FeedStatus_done,
+    FeedStatus_err
+};
+
+// Push-mode parse: input arrives in fragments through feed(). A token cut by
+// a fragment boundary is relexed once the next fragment arrives, so only the
+// unfinished token is buffered between calls.
+class ParseSession {
+public:
+    // The parser state stack allocates from the given resource.
+    ParseSession(const Parser& parser, Lexer& lexer, ParserValueStack& valueStack, ParserState startState = ParserState_none,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : mParser(parser, resource), mLexer(lexer), mValueStack(valueStack), mStartState(startState) {
+        mParser.reset();
+    }
+
+    int feed(std::span<const char> data);
+    int finish();
+
+    int status() const {
+        return mStatus;
+    }
+private:
+    int run();
+private:
+    Parser mParser;
+    Lexer& mLexer;
+    ParserValueStack& mValueStack;
+    ParserState mStartState;
+
+    ChunkSource mSource;
+    LexerResultInfo mResultInfo;
+    int mStatus = FeedStatus_needMore;
+};
+
+#endif
@@ -0,0 +1,125 @@
+#include "ParseStats.hpp"
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+namespace {
+
+struct StatTotals {
+    std::mutex mutex;
+    ParseStats stats;
+};
+
+StatTotals& totals() {
+    static StatTotals totals;
+    return totals;
+}
+
+struct LocalStats {
+    ParseStats stats;
+
+    ~LocalStats() {
+        StatTotals& all = totals();
+        std::lock_guard lock(all.mutex);
+        all.stats.merge(stats);
+    }
+};
+
+thread_local LocalStats localStats;
+
+}
+
+uint64_t StatCounts::get(long long key) const {
+    if (key >= 0 && (size_t)key < mDense.size()) {
+        return mDense[key];
+    }
+
+    auto it = mSparse.find(key);
+    return it == mSparse.end() ? 0 : it->second;
+}
+
+void StatCounts::merge(const StatCounts& other) {
+    for (size_t key = 0; key < other.mDense.size(); ++key) {
+        if (other.mDense[key]) {
+            add((long long)key, other.mDense[key]);
+        }
+    }
+    for (auto& [key, count] : other.mSparse) {
+        add(key, count);
+    }
+}
+
+void StatCounts::clear() {
+    mDense.clear();
+    mSparse.clear();
+}
+
+void StatCounts::writeJson(std::ostream& stream) const {
+    std::map<long long, uint64_t> sorted(mSparse.begin(), mSparse.end());
+    for (size_t key = 0; key < mDense.size(); ++key) {
+        if (mDense[key]) {
+            sorted[(long long)key] = mDense[key];
+        }
+    }
+
+    stream << '{';
+    const char* sep = "";
+    for (auto& [key, count] : sorted) {
+        stream << sep << '"' << key << "\":" << count;
+        sep = ",";
+    }
+    stream << '}';
+}
+
+void ParseStats::merge(const ParseStats& other) {
+    lexerStateBytes.merge(other.lexerStateBytes);
+    checkerCalls += other.checkerCalls;
+    skips += other.skips;
+    tokens.merge(other.tokens);
+    shifts += other.shifts;
+    reduces.merge(other.reduces);
+    stateVisits.merge(other.stateVisits);
+    maxStackDepth = std::max(maxStackDepth, other.maxStackDepth);
+}
+
+void ParseStats::clear() {
+    *this = ParseStats {};
+}
+
+void ParseStats::writeJson(std::ostream& stream) const {
+    stream << "{\"lexer\":{\"stateBytes\":";
+    lexerStateBytes.writeJson(stream);
+    stream << ",\"checkerCalls\":" << checkerCalls << ",\"skips\":" << skips << ",\"tokens\":";
+    tokens.writeJson(stream);
+    stream << "},\"parser\":{\"shifts\":" << shifts << ",\"reduces\":";
+    reduces.writeJson(stream);
+    stream << ",\"stateVisits\":";
+    stateVisits.writeJson(stream);
+    stream << ",\"maxStackDepth\":" << maxStackDepth << "}}";
+}
+
+ParseStats& ParseStats::local() {
+    return localStats.stats;
+}
+
+void ParseStats::flush() {
+    StatTotals& all = totals();
+    std::lock_guard lock(all.mutex);
+    all.stats.merge(localStats.stats);
+    localStats.stats.clear();
+}
+
+ParseStats ParseStats::collect() {
+    StatTotals& all = totals();
+    std::lock_guard lock(all.mutex);
+    ParseStats merged = all.stats;
+    merged.merge(localStats.stats);
+    return merged;
+}
+
+void ParseStats::reset() {
+    StatTotals& all = totals();
+    std::lock_guard lock(all.mutex);
+    all.stats.clear();
+    localStats.stats.clear();
+}
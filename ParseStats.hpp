@@ -0,0 +1,66 @@
+#ifndef PARSESTATS_HPP
+#define PARSESTATS_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+// Hot-path counters, compiled in with the LRPARSER_STATS option. Without it
+// LRPARSER_STAT expands to nothing and the counters stay zero.
+#ifdef LRPARSER_STATS
+#define LRPARSER_STAT(stmt) do { stmt; } while (0)
+#else
+#define LRPARSER_STAT(stmt) ((void)0)
+#endif
+
+// Counts by key: small keys index a vector, the rest go to a map.
+class StatCounts {
+public:
+    void add(long long key, uint64_t count = 1) {
+        if (key >= 0 && key < StatCounts_maxDense) {
+            if ((size_t)key >= mDense.size()) {
+                mDense.resize(key + 1);
+            }
+            mDense[key] += count;
+            return;
+        }
+        mSparse[key] += count;
+    }
+
+    uint64_t get(long long key) const;
+    void merge(const StatCounts& other);
+    void clear();
+    void writeJson(std::ostream& stream) const;
+private:
+    static constexpr long long StatCounts_maxDense = 4096;
+
+    std::vector<uint64_t> mDense;
+    std::unordered_map<long long, uint64_t> mSparse;
+};
+
+// Each thread counts into its own ParseStats, merged into the process totals
+// when the thread exits or calls flush().
+struct ParseStats {
+    StatCounts lexerStateBytes;     // characters consumed, by lexer state
+    uint64_t checkerCalls{};
+    uint64_t skips{};
+    StatCounts tokens;              // tokens lexed, by TokenID; peeks count too
+    uint64_t shifts{};
+    StatCounts reduces;             // by rule index
+    StatCounts stateVisits;
+    uint64_t maxStackDepth{};
+
+    void merge(const ParseStats& other);
+    void clear();
+    void writeJson(std::ostream& stream) const;
+
+    static ParseStats& local();
+    static void flush();
+    // The totals merged so far plus the calling thread's counters.
+    static ParseStats collect();
+    // Clears the totals and the calling thread's counters.
+    static void reset();
+};
+
+#endif
@@ -0,0 +1,25 @@
+#include "ParseTape.hpp"
+
+int ParseTape::record(Parser& parser, Lexer& lexer, LexerSource& source, ParserState startState) {
+    if (parser.getTables() != mTables) {
+        if (!mEvents.empty()) {
+            return ParseStatus_err;
+        }
+        mTables = parser.getTables();
+    }
+
+    LexerResultInfo resultInfo;
+    int status = ParseStatus_ok;
+
+    parser.reset();
+    while (ParseStatus_ok == (status = parser.parseNext<ParseTape>({
+        .lexer = lexer,
+        .source = source,
+        .lexerResInfo = resultInfo,
+        .valueStack = *this,
+        .startState = startState,
+    }))) {
+
+    }
+    return status;
+}
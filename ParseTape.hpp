@@ -0,0 +1,73 @@
+#ifndef PARSETAPE_HPP
+#define PARSETAPE_HPP
+
+#include "Parser.hpp"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using TapeEvent = uint32_t;
+
+constexpr TapeEvent TapeEvent_reduce = 1;
+
+// Flat postfix log of a parse: (shift tokenIndex) and (reduce ruleIndex)
+// packed into 32-bit events. Recording goes through the templated driver, so
+// the parse loop never calls into user code; replay() feeds any value stack
+// later, as often as needed and from any thread.
+class ParseTape final {
+public:
+    explicit ParseTape(const Parser& parser) : mTables(parser.getTables()) { }
+
+    // Appends the parse to the tape. An empty tape takes the parser's
+    // tables; a parser over other tables than the recorded events gives
+    // ParseStatus_err.
+    int record(Parser& parser, Lexer& lexer, LexerSource& source, ParserState startState = ParserState_none);
+
+    int pushTerm(const Token& token) {
+        mEvents.push_back((TapeEvent)mTokens.size() << 1);
+        mTokens.push_back(token);
+        return 0;
+    }
+
+    bool pushReduced(const GrammarRule& rule) {
+        mEvents.push_back((TapeEvent)(&rule - mTables->rules.data()) << 1 | TapeEvent_reduce);
+        return true;
+    }
+
+    bool pop() {
+        return false;
+    }
+
+    template <typename ValueStack>
+    void replay(ValueStack& valueStack) const {
+        const GrammarRule* rules = mTables->rules.data();
+        const Token* tokens = mTokens.data();
+
+        for (TapeEvent event : mEvents) {
+            if (event & TapeEvent_reduce) {
+                valueStack.pushReduced(rules[event >> 1]);
+            } else {
+                valueStack.pushTerm(tokens[event >> 1]);
+            }
+        }
+    }
+
+    void clear() {
+        mEvents.clear();
+        mTokens.clear();
+    }
+
+    const std::vector<TapeEvent>& events() const {
+        return mEvents;
+    }
+
+    const std::vector<Token>& tokens() const {
+        return mTokens;
+    }
+private:
+    std::shared_ptr<const ParserTables> mTables;
+    std::vector<TapeEvent> mEvents;
+    std::vector<Token> mTokens;
+};
+
+#endif
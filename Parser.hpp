@@ -1,47 +1,30 @@
 #ifndef PARSER_HPP
 #define PARSER_HPP
 
+#include "CompressedTables.hpp"
+#include "LazyTables.hpp"
 #include "Lexer.hpp"
+#include "ParseStats.hpp"
+#include "ParserDefs.hpp"
+#include "TableProfile.hpp"
+#include "TerminalMasks.hpp"
+#include "Tracer.hpp"
+#include <algorithm>
 #include <list>
+#include <memory>
+#include <utility>
 #include <vector>
 
-enum ParserActType_ { 
-    ParserActType_shift,
-    ParserActType_reduce,
-    ParserActType_accept,
-    ParserActType_error
+struct ParserTables {
+    ActionTable actionTable;
+    GotoTable gotoTable;
+    DefaultReduceTable defaultReductions;
+    GrammarRuleList rules;
+    std::shared_ptr<const CompressedTables> compressed;
+    std::shared_ptr<LazyTables> lazy;
+    std::shared_ptr<const TerminalMasks> expected;
 };
 
-enum ParseStatus_ {
-    ParseStatus_ok,
-    ParseStatus_skip = -3,
-    ParseStatus_finish = -2,
-    ParseStatus_err = -1
-};
-
-using RuleTag = long long;
-using ParserState = long long;
-
-constexpr ParserState ParserState_none = 0; 
-
-struct Action {
-    ParserActType_ type = ParserActType_error;
-    ParserState value = ParserState_none;
-};
-
-struct GrammarRule {
-    TokenID lhsId;     
-    size_t rhsSize;   
-    RuleTag tag;
-};
-
-using ActionTable = std::unordered_map<TokenID, std::unordered_map<TokenID, Action>>;
-using GotoTable = std::unordered_map<TokenID, std::unordered_map<TokenID, TokenID>>;
-using ParserStateStack = std::vector<ParserState>;
-using GrammarRuleList = std::vector<GrammarRule>;
-
-using ReduceList = std::vector<Token>;
-
 class ParserValueStack {
 public:
     virtual int pushTerm(const Token& token) = 0;
@@ -50,30 +33,297 @@ public:
 private:
 };
 
-struct ParserInputArgs {
+template <typename ValueStack>
+struct BasicParserInputArgs {
     Lexer& lexer;
     LexerSource& source;
     LexerResultInfo& lexerResInfo;
-    ParserValueStack& valueStack;
+    ValueStack& valueStack;
     const ParserState& startState;
 };
 
+using ParserInputArgs = BasicParserInputArgs<ParserValueStack>;
+
 class Parser {
 public:
-    Parser() = default;
-    Parser(Parser&& parser) {
-        operator=(std::move(parser));
-    }
+    Parser() : mTables(emptyTables()) { }
+    Parser(std::shared_ptr<const ParserTables> tables) : mTables(std::move(tables)) { }
+    Parser(std::shared_ptr<const ParserTables> tables, std::pmr::memory_resource* resource)
+        : mTables(std::move(tables)), mStateStack(resource) { }
+    Parser(const Parser& parser, std::pmr::memory_resource* resource)
+        : mTables(parser.mTables), mStateStack(parser.mStateStack, resource), mProfile(parser.mProfile) { }
+    Parser(const Parser& parser) = default;
+    // A moved-from parser keeps empty tables, so parsing with it fails
+    // cleanly instead of dereferencing null.
+    Parser(Parser&& parser) noexcept
+        : mTables(std::exchange(parser.mTables, emptyTables())),
+          mStateStack(std::move(parser.mStateStack)), mProfile(parser.mProfile) { }
 
-    Parser& operator=(Parser&& parser);
+    Parser& operator=(const Parser& parser) = default;
+    Parser& operator=(Parser&& parser) noexcept;
 
     int parseNext(const ParserInputArgs& args);
-    void init(ActionTable&& actionTable, GotoTable&& gotoTable, GrammarRuleList&& rules);
+
+    template <typename ValueStack>
+    int parseNext(const BasicParserInputArgs<ValueStack>& args);
+
+    template <typename ValueStack>
+    int feedToken(const Token& token, ValueStack& valueStack, ParserState startState = ParserState_none);
+
+    void init(ActionTable&& actionTable, GotoTable&& gotoTable, GrammarRuleList&& rules, DefaultReduceTable&& defaultReductions = {});
+    void init(ParserTables&& tables);
+    void reset() {
+        mStateStack.clear();
+    }
+
+    // Moves the state stack to the given resource, e.g. a per-thread pool for
+    // short parses. The current stack is dropped.
+    void setMemoryResource(std::pmr::memory_resource* resource) {
+        mStateStack = ParserStateStack(resource);
+    }
+
+    // Counts every state visited and symbol looked up into the profile,
+    // which must outlive the parse. nullptr stops the counting.
+    void setProfile(TransitionProfile* profile) {
+        mProfile = profile;
+    }
+
+    Action findAction(ParserState state, TokenID tokenId) const {
+        if (mTables->compressed) {
+            return mTables->compressed->findAction(state, tokenId);
+        }
+        if (mTables->lazy) {
+            return mTables->lazy->findAction(state, tokenId);
+        }
+
+        auto itActionRow = mTables->actionTable.find(state);
+        if (itActionRow == mTables->actionTable.end()) {
+            return {};
+        }
+
+        auto itAction = itActionRow->second.find(tokenId);
+        if (itAction == itActionRow->second.end()) {
+            return {};
+        }
+        return itAction->second;
+    }
+
+    bool findGoto(ParserState state, TokenID symbolId, ParserState& next) const {
+        if (mTables->compressed) {
+            return mTables->compressed->findGoto(state, symbolId, next);
+        }
+        if (mTables->lazy) {
+            return mTables->lazy->findGoto(state, symbolId, next);
+        }
+
+        auto itGotoRow = mTables->gotoTable.find(state);
+        if (itGotoRow == mTables->gotoTable.end()) {
+            return false;
+        }
+
+        auto itGoto = itGotoRow->second.find(symbolId);
+        if (itGoto == itGotoRow->second.end()) {
+            return false;
+        }
+        next = itGoto->second;
+        return true;
+    }
+
+    const TerminalMask* findExpected(ParserState state) const {
+        if (mTables->lazy) {
+            return mTables->lazy->findExpected(state);
+        }
+        return mTables->expected ? mTables->expected->find(state) : nullptr;
+    }
+
+    const ParserState* findDefaultReduction(ParserState state) const {
+        if (mTables->defaultReductions.empty()) {
+            return nullptr;
+        }
+
+        auto itDefault = mTables->defaultReductions.find(state);
+        if (itDefault == mTables->defaultReductions.end()) {
+            return nullptr;
+        }
+        return &itDefault->second;
+    }
+
+    const GrammarRuleList& getRules() const {
+        return mTables->rules;
+    }
+
+    const std::shared_ptr<const ParserTables>& getTables() const {
+        return mTables;
+    }
+private:
+    // Shared by default-constructed and moved-from parsers.
+    static const std::shared_ptr<const ParserTables>& emptyTables();
+
+    template <typename ValueStack>
+    int reduce(ParserState ruleIndex, ValueStack& valueStack);
+
+    static void traceShift(TokenID tokenId) {
+        if (Tracer::enabled() && Tracer::sample(TraceSample_token)) {
+            Tracer::instant("shift", "parser", tokenId);
+        }
+    }
+
+    void profileState(ParserState state) {
+        if (mProfile) {
+            mProfile->states.add(state);
+        }
+    }
+
+    void profileSymbol(TokenID symbolId) {
+        if (mProfile) {
+            mProfile->symbols.add(symbolId);
+        }
+    }
+
+    void countStackDepth() const {
+        ParseStats& stats = ParseStats::local();
+        stats.maxStackDepth = std::max<uint64_t>(stats.maxStackDepth, mStateStack.size());
+    }
 private:
-    ActionTable mActionTable;
-    GotoTable mGotoTable;
+    std::shared_ptr<const ParserTables> mTables;
     ParserStateStack mStateStack;
-    GrammarRuleList mGrammarRules;
+    TransitionProfile* mProfile{};
 };
 
+template <typename ValueStack>
+int Parser::parseNext(const BasicParserInputArgs<ValueStack>& args) {
+    if (mStateStack.empty()) {
+        mStateStack.push_back(args.startState);
+    }
+
+    ParserState currentState = mStateStack.back();
+    LRPARSER_STAT(ParseStats::local().stateVisits.add(currentState));
+    profileState(currentState);
+
+    if (const ParserState* defaultRule = findDefaultReduction(currentState)) {
+        return reduce(*defaultRule, args.valueStack);
+    }
+
+    Lexer& lexer = args.lexer;
+    Token tok;
+    const TerminalMask* expected = findExpected(currentState);
+    int status = lexer.peek({
+        tok, args.source, args.lexerResInfo, token_none, expected
+    });
+
+    TokenID tokenId = token_lexer_end;
+
+    if (status == TKN_OK) {
+        tokenId = tok.info()->id;
+    }
+
+    if (status == TKN_ERR) {
+        return ParseStatus_err;
+    }
+
+    profileSymbol(tokenId);
+    Action action = findAction(currentState, tokenId);
+
+    switch (action.type) {
+        case ParserActType_shift: {
+            mStateStack.push_back(action.value);
+            LRPARSER_STAT(ParseStats::local().shifts++; countStackDepth());
+            traceShift(tokenId);
+
+            lexer.next({tok, args.source, args.lexerResInfo, token_none, expected});
+            args.valueStack.pushTerm(tok);
+            return ParseStatus_ok;
+        }
+
+        case ParserActType_reduce:
+            return reduce(action.value, args.valueStack);
+
+        case ParserActType_accept:
+            return ParseStatus_finish;
+
+        case ParserActType_error:
+        default:
+            return ParseStatus_err;
+    }
+}
+
+template <typename ValueStack>
+int Parser::feedToken(const Token& token, ValueStack& valueStack, ParserState startState) {
+    if (mStateStack.empty()) {
+        mStateStack.push_back(startState);
+    }
+
+    TokenID tokenId = token.info() ? token.info()->id : (TokenID)token_lexer_end;
+
+    while (true) {
+        ParserState currentState = mStateStack.back();
+        LRPARSER_STAT(ParseStats::local().stateVisits.add(currentState));
+        profileState(currentState);
+
+        if (const ParserState* defaultRule = findDefaultReduction(currentState)) {
+            if (reduce(*defaultRule, valueStack) != ParseStatus_ok) {
+                return ParseStatus_err;
+            }
+            continue;
+        }
+
+        profileSymbol(tokenId);
+        Action action = findAction(currentState, tokenId);
+
+        switch (action.type) {
+            case ParserActType_shift:
+                mStateStack.push_back(action.value);
+                LRPARSER_STAT(ParseStats::local().shifts++; countStackDepth());
+                traceShift(tokenId);
+                valueStack.pushTerm(token);
+                return ParseStatus_ok;
+
+            case ParserActType_reduce:
+                if (reduce(action.value, valueStack) != ParseStatus_ok) {
+                    return ParseStatus_err;
+                }
+                break;
+
+            case ParserActType_accept:
+                return ParseStatus_finish;
+
+            case ParserActType_error:
+            default:
+                return ParseStatus_err;
+        }
+    }
+}
+
+template <typename ValueStack>
+int Parser::reduce(ParserState ruleIndex, ValueStack& valueStack) {
+    const GrammarRuleList& rules = mTables->rules;
+    if (ruleIndex < 0 || ruleIndex >= (long long)rules.size()) {
+        return ParseStatus_err;
+    }
+
+    const GrammarRule& rule = rules[ruleIndex];
+    LRPARSER_STAT(ParseStats::local().reduces.add(ruleIndex));
+    if (Tracer::enabled() && Tracer::sample(TraceSample_reduce)) {
+        Tracer::instant("reduce", "parser", ruleIndex);
+    }
+
+    for (size_t i = 0; i < rule.rhsSize; ++i) {
+        if (!mStateStack.empty()) {
+            mStateStack.pop_back();
+        }
+    }
+
+    valueStack.pushReduced(rule);
+
+    profileSymbol(rule.lhsId);
+    ParserState nextState = ParserState_none;
+    if (!findGoto(mStateStack.back(), rule.lhsId, nextState)) {
+        return ParseStatus_err;
+    }
+
+    mStateStack.push_back(nextState);
+    LRPARSER_STAT(countStackDepth());
+    return ParseStatus_ok;
+}
+
 #endif
\ No newline at end of file
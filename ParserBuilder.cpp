@@ -2,6 +2,10 @@
 #include "Lexer.hpp"
 #include "LexerDefs.hpp"
 #include "LexerSources.hpp"
+#include "TableProfile.hpp"
+#include "Tracer.hpp"
+#include <deque>
+#include <fstream>
 
 int grammar_lexer_implies(const TokenSwitchArgs& args) {
 	bool isBlank = isspace(args.ch) || iscntrl(args.ch) || isblank(args.ch);
@@ -31,131 +35,217 @@ int grammar_lexer_implies(const TokenSwitchArgs& args) {
 	return TKN_ERR;
 }
 
-void ParserBuilder::computeAllFirstSets(const std::vector<TokRule>& rules) {
-    bool changed = true;
-    while (changed) {
-        changed = false;
-        for (const auto& rule : rules) {
-            TokenID lhs = rule.lhs.info()->id;
-            bool derivesEpsilon = true;
-
-            for (const auto& sym : rule.rhs) {
-                if (sym.info()->category == TokenCategory_term) {
-                    if (mFirstSets[lhs].insert(sym.info()->id).second) {
-						changed = true;
-					}
-                    derivesEpsilon = false;
-                    break;
-                } else {
-                    bool symHasEpsilon = false;
-                    for (TokenID termId : mFirstSets[sym.info()->id]) {
-                        if (termId == token_none) {
-                            symHasEpsilon = true;
-                        } else {
-                            if (mFirstSets[lhs].insert(termId).second) {
-								changed = true;
-							}
-                        }
-                    }
-                    
-                    if (!symHasEpsilon) {
-                        derivesEpsilon = false;
-                        break;
-                    }
+void ParserBuilder::computeClosure(StateSet& set, const std::vector<TokRule>& rules) {
+    TraceScope trace("computeClosure", "builder", TraceSample_closure);
+    std::pmr::vector<LRItem> worklist(set.begin(), set.end(), mResource);
+    std::pmr::vector<FirstSets::Word> lookaheads(mFirstSets.words(), mResource);
+
+    while (!worklist.empty()) {
+        LRItem item = worklist.back();
+        worklist.pop_back();
+
+        const TokRule& rule = rules[item.ruleIndex];
+        if (item.dotPos >= rule.rhs.size() || rule.rhs[item.dotPos].info()->category != TokenCategory_nonterm) {
+            continue;
+        }
+
+        std::fill(lookaheads.begin(), lookaheads.end(), 0);
+        bool nullable = mFirstSets.firstOf(rule, item.dotPos + 1, lookaheads);
+        const std::vector<int>& expanded = mFirstSets.rulesOf(mFirstSets.nonterminalIndex(rule.rhs[item.dotPos].info()->id));
+
+        auto addItems = [&](TokenID la) {
+            for (int rIdx : expanded) {
+                LRItem newItem {rIdx, 0, la};
+                if (set.insert(newItem).second) {
+                    worklist.push_back(newItem);
                 }
             }
+        };
 
-            if (derivesEpsilon) {
-                if (mFirstSets[lhs].insert(token_none).second) {
-					changed = true;
-				}
-            }
+        mFirstSets.forEachTerminal(lookaheads, addItems);
+        if (nullable) {
+            addItems(item.lookaheadId);
         }
     }
 }
 
-std::set<TokenID> ParserBuilder::computeFirst(const TokRule& rule, int startIdx, TokenID currentLookahead) {
-    std::set<TokenID> result;
-    bool allDeriveEpsilon = true;
-
-    for (size_t i = startIdx; i < rule.rhs.size(); ++i) {
-        TokenID symId = rule.rhs[i].info()->id;
-        
-        if (rule.rhs[i].info()->category == TokenCategory_term) {
-            result.insert(symId);
-            allDeriveEpsilon = false;
-            break; 
+StateSet ParserBuilder::computeGoto(const StateSet& items, TokenID symbolId, const std::vector<TokRule>& rules) {
+    StateSet movedItems(mResource);
+    for (const auto& item : items) {
+        const auto& rule = rules[item.ruleIndex];
+        if (item.dotPos < rule.rhs.size() && rule.rhs[item.dotPos].info()->id == symbolId) {
+            movedItems.insert({item.ruleIndex, item.dotPos + 1, item.lookaheadId});
         }
+    }
+    
+    computeClosure(movedItems, rules);
+    return movedItems;
+}
+
+void ParserBuilder::addAction(std::unordered_map<TokenID, Action>& actionRow, TokenID lookahead, const Action& action) {
+    auto [it, inserted] = actionRow.try_emplace(lookahead, action);
+    Action& current = it->second;
+    if (inserted || (current.type == action.type && current.value == action.value) || current.type == ParserActType_error) {
+        return;
+    }
+
+    if (current.type == ParserActType_reduce && action.type == ParserActType_reduce) {
+        current.value = std::min(current.value, action.value);
+        ++mTableStats.conflicts;
+        return;
+    }
+
+    bool shiftReduce = (current.type == ParserActType_shift && action.type == ParserActType_reduce)
+        || (current.type == ParserActType_reduce && action.type == ParserActType_shift);
+    if (!shiftReduce) {
+        ++mTableStats.conflicts;
+        return;
+    }
 
-        bool hasEpsilon = false;
-        for (TokenID f : mFirstSets[symId]) {
-            if (f == token_none) {
-                hasEpsilon = true;
+    const Action& shift = current.type == ParserActType_shift ? current : action;
+    const Action& reduce = current.type == ParserActType_reduce ? current : action;
+
+    // Yacc rules: the higher of the rule's and the lookahead's precedence
+    // wins, a tie goes by associativity, and without both a shift.
+    auto itPrec = mPrecedence.find(lookahead);
+    const Precedence& rulePrec = mRulePrecedence[reduce.value];
+    if (itPrec == mPrecedence.end() || rulePrec.level == 0) {
+        current = shift;
+        ++mTableStats.conflicts;
+        return;
+    }
+
+    const Precedence& tokenPrec = itPrec->second;
+    if (rulePrec.level != tokenPrec.level) {
+        current = rulePrec.level > tokenPrec.level ? reduce : shift;
+    } else if (tokenPrec.assoc == PrecAssoc_left) {
+        current = reduce;
+    } else if (tokenPrec.assoc == PrecAssoc_right) {
+        current = shift;
+    } else {
+        current = {ParserActType_error, 0};
+    }
+}
+
+template <typename StateOf>
+void ParserBuilder::buildRow(const StateSet& set, const std::vector<TokRule>& rules, StateOf&& stateOf, std::unordered_map<TokenID, Action>& actionRow, std::unordered_map<TokenID, TokenID>& gotoRow) {
+    std::pmr::set<TokenID> processedSymbols(mResource);
+
+    for (const LRItem& item : set) {
+        const TokRule& rule = rules[item.ruleIndex];
+        
+        if (item.dotPos == rule.rhs.size()) {
+            if (item.ruleIndex == 0 && item.lookaheadId == token_lexer_end) {
+                addAction(actionRow, token_lexer_end, {ParserActType_accept, 0});
             } else {
-                result.insert(f);
+                addAction(actionRow, item.lookaheadId, {ParserActType_reduce, (ParserState)item.ruleIndex});
             }
+            continue;
         }
 
-        if (!hasEpsilon) {
-            allDeriveEpsilon = false;
-            break;
+        TokenID symId = rule.rhs[item.dotPos].info()->id;
+        if (processedSymbols.count(symId)) {
+            continue;
+        }
+        processedSymbols.insert(symId);
+
+        StateSet nextSet = computeGoto(set, symId, rules);
+        if (nextSet.empty()) {
+            continue;
         }
-    }
 
-    if (allDeriveEpsilon) {
-        result.insert(currentLookahead);
+        ParserState nextIdx = stateOf(std::move(nextSet));
+        if (rule.rhs[item.dotPos].info()->category == TokenCategory_nonterm) {
+            gotoRow[symId] = nextIdx;
+        } else {
+            addAction(actionRow, symId, {ParserActType_shift, nextIdx});
+        }
     }
-    return result;
 }
 
-void ParserBuilder::computeClosure(StateSet& set, const std::vector<TokRule>& rules) {
-    bool changed = true;
-    while (changed) {
-        changed = false;
-        StateSet newItems;
-        for (const LRItem& item : set) {
-            const TokRule& rule = rules[item.ruleIndex];
-            if (item.dotPos < rule.rhs.size()) {
-                Token nextSymbol = rule.rhs[item.dotPos];
-                if (nextSymbol.info()->category == TokenCategory_nonterm) {
-                    std::set<TokenID> lookaheads = computeFirst(rule, item.dotPos + 1, item.lookaheadId);
-                    
-                    for (int rIdx = 0; rIdx < rules.size(); ++rIdx) {
-                        if (rules[rIdx].lhs.info()->id == nextSymbol.info()->id) {
-                            for (int la : lookaheads) {
-                                if (set.find(LRItem {rIdx, 0, la }) == set.end()) {
-                                    newItems.insert(LRItem {rIdx, 0, la });
-                                    changed = true;
-                                }
-                            }
-                        }
-                    }
-                }
+// Builds rows on demand for ParserBuildFlags_lazyTables. It keeps its own
+// copy of the rules and of the token infos they point to, so the tables
+// outlive the builder and its grammar lexer.
+class ParserBuilder::LazyGrammar final : public LazyTables {
+public:
+    LazyGrammar(const std::vector<TokRule>& rules, const ParserBuilder& builder)
+        : LazyTables(builder.mFlags & ParserBuildFlags_stateLexing) {
+        std::unordered_map<const TokenInfo*, const TokenInfo*> infos;
+        auto copyToken = [&](const Token& token) {
+            auto [it, inserted] = infos.try_emplace(token.info());
+            if (inserted) {
+                it->second = &mInfos.emplace_back(*token.info());
+            }
+            return Token(it->second, token.value());
+        };
+
+        for (const TokRule& rule : rules) {
+            TokRule& copy = mRules.emplace_back(TokRule { .lhs = copyToken(rule.lhs), .tag = rule.tag, .prec = rule.prec });
+            for (const Token& sym : rule.rhs) {
+                copy.rhs.push_back(copyToken(sym));
             }
         }
-        set.insert(newItems.begin(), newItems.end());
+        mBuilder.mFirstSets = builder.mFirstSets;
+        mBuilder.mPrecedence = builder.mPrecedence;
+        mBuilder.mRulePrecedence = builder.mRulePrecedence;
+
+        StateSet startSet;
+        startSet.insert({0, 0, token_lexer_end});
+        mBuilder.computeClosure(startSet, mRules);
+        mStateIndex.emplace(startSet, 0);
+        mStates.push_back(std::move(startSet));
     }
-}
-
-StateSet ParserBuilder::computeGoto(const StateSet& items, TokenID symbolId, const std::vector<TokRule>& rules) {
-    StateSet movedItems;
-    for (const auto& item : items) {
-        const auto& rule = rules[item.ruleIndex];
-        if (item.dotPos < rule.rhs.size() && rule.rhs[item.dotPos].info()->id == symbolId) {
-            movedItems.insert({item.ruleIndex, item.dotPos + 1, item.lookaheadId});
+protected:
+    bool buildRow(ParserState state, LazyRow& row) override {
+        if (state < 0 || state >= (ParserState)mStates.size()) {
+            return false;
         }
+
+        auto stateOf = [&](StateSet&& set) {
+            auto [it, inserted] = mStateIndex.try_emplace(set, (ParserState)mStates.size());
+            if (inserted) {
+                mStates.push_back(std::move(set));
+            }
+            return it->second;
+        };
+
+        mBuilder.buildRow(mStates[state], mRules, stateOf, row.actions, row.gotos);
+        return true;
     }
-    
-    computeClosure(movedItems, rules);
-    return movedItems;
-}
+private:
+    ParserBuilder mBuilder;
+    std::deque<TokenInfo> mInfos;
+    std::vector<TokRule> mRules;
+    std::deque<StateSet> mStates;
+    std::map<StateSet, ParserState> mStateIndex;
+};
 
 void ParserBuilder::buildTables(Parser& parser, const std::vector<TokRule>& rules) {
-    std::vector<StateSet> states;
-    std::map<StateSet, int> stateToIndex;
-    std::queue<int> worklist;
+    TraceScope trace("buildTables", "builder");
+    mTableStats = {};
 
-    StateSet startSet;
+	GrammarRuleList ruleList;
+	for (auto& val : rules) {
+		ruleList.push_back(GrammarRule {
+			.lhsId = val.lhs.info()->id,
+			.rhsSize = val.rhs.size(),
+            .tag = val.tag
+		});
+	}
+
+    if (mFlags & ParserBuildFlags_lazyTables) {
+        parser.init(ParserTables {
+            .rules = std::move(ruleList),
+            .lazy = std::make_shared<LazyGrammar>(rules, *this)
+        });
+        return;
+    }
+
+    std::pmr::vector<StateSet> states(mResource);
+    std::pmr::map<StateSet, int> stateToIndex(mResource);
+    std::queue<int, std::pmr::deque<int>> worklist(std::pmr::deque<int>{mResource});
+
+    StateSet startSet(mResource);
     startSet.insert({0, 0, token_lexer_end}); 
     computeClosure(startSet, rules);
     
@@ -166,61 +256,208 @@ void ParserBuilder::buildTables(Parser& parser, const std::vector<TokRule>& rule
 	ActionTable actionTable;
 	GotoTable gotoTable;
 
+    auto stateOf = [&](StateSet&& nextSet) {
+        auto [it, inserted] = stateToIndex.try_emplace(nextSet, (int)states.size());
+        if (inserted) {
+            states.push_back(std::move(nextSet));
+            worklist.push(it->second);
+        }
+        return (ParserState)it->second;
+    };
+
     while (!worklist.empty()) {
         int currIdx = worklist.front();
         worklist.pop();
-        const StateSet currSet = states[currIdx];
-
-        std::set<TokenID> processedSymbols;
-
-        for (const LRItem& item : currSet) {
-            const TokRule& rule = rules[item.ruleIndex];
-            
-			if (item.dotPos == rule.rhs.size()) {
-                if (item.ruleIndex == 0 && item.lookaheadId == token_lexer_end) {
-                    actionTable[currIdx][token_lexer_end] = {ParserActType_accept, 0};
-                } else {
-                    actionTable[currIdx][item.lookaheadId] = {ParserActType_reduce, (ParserState)item.ruleIndex};
+        const StateSet currSet(states[currIdx], mResource);
+
+        std::unordered_map<TokenID, Action> actionRow;
+        std::unordered_map<TokenID, TokenID> gotoRow;
+        buildRow(currSet, rules, stateOf, actionRow, gotoRow);
+
+        if (!actionRow.empty()) {
+            actionTable[currIdx] = std::move(actionRow);
+        }
+        if (!gotoRow.empty()) {
+            gotoTable[currIdx] = std::move(gotoRow);
+        }
+    }
+
+    if (mFlags & ParserBuildFlags_unitElimination) {
+        TraceScope unitTrace("eliminateUnitRules", "builder");
+        eliminateUnitRules(actionTable, gotoTable, rules, states.size());
+    }
+
+    DefaultReduceTable defaultReductions;
+    if (mFlags & ParserBuildFlags_defaultReductions) {
+        defaultReductions = computeDefaultReductions(actionTable);
+    }
+
+    ParserTables tables {
+        .actionTable = std::move(actionTable),
+        .gotoTable = std::move(gotoTable),
+        .defaultReductions = std::move(defaultReductions),
+        .rules = std::move(ruleList)
+    };
+
+    if (mProfile) {
+        TraceScope profileTrace("renumberStates", "builder");
+        renumberStates(tables, *mProfile);
+    }
+
+    if (mFlags & ParserBuildFlags_stateLexing) {
+        TraceScope maskTrace("terminalMasks", "builder");
+        tables.expected = std::make_shared<const TerminalMasks>(tables.actionTable);
+    }
+
+    mTableStats.bytesBefore = estimateTableBytes(tables);
+    mTableStats.bytesAfter = mTableStats.bytesBefore;
+
+    if (mFlags & ParserBuildFlags_compressTables) {
+        TraceScope compressTrace("compressTables", "builder");
+        auto compressed = std::make_shared<const CompressedTables>(tables, mProfile);
+        tables.actionTable = {};
+        tables.gotoTable = {};
+        mTableStats.bytesAfter = compressed->bytes() + estimateTableBytes(tables);
+        tables.compressed = std::move(compressed);
+    }
+
+	parser.init(std::move(tables));
+}
+
+static bool isUnitRule(const std::vector<TokRule>& rules, ParserState ruleIndex) {
+    return ruleIndex > 0 && rules[ruleIndex].rhs.size() == 1 && rules[ruleIndex].tag == 0;
+}
+
+void ParserBuilder::eliminateUnitRules(ActionTable& actionTable, GotoTable& gotoTable, const std::vector<TokRule>& rules, ParserState stateCount) {
+    constexpr ParserState noMerge = -1;
+    std::map<std::pair<ParserState, ParserState>, ParserState> merged;
+
+    bool changed = true;
+    for (size_t pass = 0; changed && pass <= rules.size(); ++pass) {
+        changed = false;
+
+        std::vector<std::pair<ParserState, TokenID>> edges;
+        for (const auto& [state, row] : gotoTable) {
+            for (const auto& [symId, next] : row) {
+                edges.emplace_back(state, symId);
+            }
+        }
+        for (const auto& [state, row] : actionTable) {
+            for (const auto& [symId, action] : row) {
+                if (action.type == ParserActType_shift) {
+                    edges.emplace_back(state, symId);
                 }
-                continue;
             }
+        }
 
-            TokenID symId = rule.rhs[item.dotPos].info()->id;
-            if (processedSymbols.count(symId)) {
+        for (const auto& [state, symId] : edges) {
+            auto itGotoRow = gotoTable.find(state);
+            bool isGoto = itGotoRow != gotoTable.end() && itGotoRow->second.count(symId);
+            ParserState target = isGoto ? itGotoRow->second[symId] : actionTable[state][symId].value;
+
+            // Bypassing A -> B in the state reached over B means continuing
+            // as if A had already been pushed over the same stack position.
+            ParserState unitRule = noMerge;
+            for (const auto& [la, action] : actionTable[target]) {
+                if (action.type == ParserActType_reduce && isUnitRule(rules, action.value)) {
+                    unitRule = action.value;
+                    break;
+                }
+            }
+            if (unitRule == noMerge) {
                 continue;
             }
-            processedSymbols.insert(symId);
 
-            StateSet nextSet = computeGoto(currSet, symId, rules);
-            if (nextSet.empty()) {
+            TokenID lhsId = rules[unitRule].lhs.info()->id;
+            if (itGotoRow == gotoTable.end() || !itGotoRow->second.count(lhsId)) {
                 continue;
             }
+            ParserState unitTarget = itGotoRow->second[lhsId];
+
+            auto key = std::make_pair(target, unitTarget);
+            auto itMerged = merged.find(key);
+            if (itMerged == merged.end()) {
+                std::unordered_map<TokenID, Action> actionRow = actionTable[target];
+                std::unordered_map<TokenID, Action> unitActionRow = actionTable[unitTarget];
+                std::unordered_map<TokenID, TokenID> gotoRow;
+                std::unordered_map<TokenID, TokenID> unitGotoRow;
+                if (auto it = gotoTable.find(target); it != gotoTable.end()) {
+                    gotoRow = it->second;
+                }
+                if (auto it = gotoTable.find(unitTarget); it != gotoTable.end()) {
+                    unitGotoRow = it->second;
+                }
 
-            if (stateToIndex.find(nextSet) == stateToIndex.end()) {
-                stateToIndex[nextSet] = states.size();
-                states.push_back(nextSet);
-                worklist.push(stateToIndex[nextSet]);
+                for (auto it = actionRow.begin(); it != actionRow.end();) {
+                    if (it->second.type != ParserActType_reduce || it->second.value != unitRule) {
+                        ++it;
+                        continue;
+                    }
+                    auto itUnitAction = unitActionRow.find(it->first);
+                    if (itUnitAction == unitActionRow.end()) {
+                        it = actionRow.erase(it);
+                    } else {
+                        it->second = itUnitAction->second;
+                        ++it;
+                    }
+                }
+
+                bool conflict = false;
+                for (const auto& [gotoSym, gotoState] : unitGotoRow) {
+                    auto [itRow, inserted] = gotoRow.emplace(gotoSym, gotoState);
+                    if (!inserted && itRow->second != gotoState) {
+                        conflict = true;
+                        break;
+                    }
+                }
+
+                ParserState mergedState = noMerge;
+                if (!conflict) {
+                    mergedState = stateCount++;
+                    actionTable[mergedState] = std::move(actionRow);
+                    if (!gotoRow.empty()) {
+                        gotoTable[mergedState] = std::move(gotoRow);
+                    }
+                }
+                itMerged = merged.emplace(key, mergedState).first;
+            }
+
+            if (itMerged->second == noMerge) {
+                continue;
             }
 
-            int nextIdx = stateToIndex[nextSet];
-            if (rule.rhs[item.dotPos].info()->category == TokenCategory_nonterm) {
-                gotoTable[currIdx][symId] = nextIdx;
+            if (isGoto) {
+                gotoTable[state][symId] = itMerged->second;
             } else {
-                actionTable[currIdx][symId] = {ParserActType_shift, (ParserState)nextIdx};
+                actionTable[state][symId].value = itMerged->second;
             }
+            changed = true;
         }
     }
+}
 
-	GrammarRuleList ruleList;
-	for (auto& val : rules) {
-		ruleList.push_back(GrammarRule {
-			.lhsId = val.lhs.info()->id,
-			.rhsSize = val.rhs.size(),
-            .tag = val.tag
-		});
-	}
+DefaultReduceTable ParserBuilder::computeDefaultReductions(const ActionTable& actionTable) {
+    DefaultReduceTable defaultReductions;
+
+    for (const auto& [state, row] : actionTable) {
+        if (row.empty()) {
+            continue;
+        }
 
-	parser.init(std::move(actionTable), std::move(gotoTable), std::move(ruleList));
+        ParserState ruleIndex = row.begin()->second.value;
+        bool consistent = true;
+        for (const auto& [la, action] : row) {
+            if (action.type != ParserActType_reduce || action.value != ruleIndex) {
+                consistent = false;
+                break;
+            }
+        }
+
+        if (consistent) {
+            defaultReductions[state] = ruleIndex;
+        }
+    }
+    return defaultReductions;
 }
 
 ParserBuilder& ParserBuilder::initGrammarLexer() {
@@ -271,6 +508,10 @@ ParserBuilder& ParserBuilder::initGrammarLexer() {
 
 ParserBuilder& ParserBuilder::loadGrammar(const std::span<const StrRule>& grammar) {
 	LexerResultInfo resultInfo;
+	mLoadInfo = {};
+	if (grammar.empty()) {
+		return failLoad(0, "Grammar has no rules");
+	}
 	
 	std::vector<TokRule> ruleArr;
 	StateSet stateSet;
@@ -278,7 +519,7 @@ ParserBuilder& ParserBuilder::loadGrammar(const std::span<const StrRule>& gramma
 		StringSource source(grammar[i].rule);
 		
 		Token lhs;
-		mGrammarLexer.next({
+		int lhsStatus = mGrammarLexer.next({
 			.token = lhs,
 			.source = source,
 			.debug = resultInfo,
@@ -286,23 +527,30 @@ ParserBuilder& ParserBuilder::loadGrammar(const std::span<const StrRule>& gramma
 		});
 	
 		Token imp;
-		mGrammarLexer.next({
+		int impStatus = mGrammarLexer.next({
 			.token = imp,
 			.source = source,
 			.debug = resultInfo,
 			.initState = token_op,
 		});
+		if (lhsStatus != TKN_OK || !lhs.info() || impStatus != TKN_OK) {
+			return failLoad(i + 1, "Expected a symbol and '->'");
+		}
 	
 		Token rhs;
 		std::vector<Token> rhsVec;
-		while (TKN_OK == mGrammarLexer.next({
+		int rhsStatus = TKN_OK;
+		while (TKN_OK == (rhsStatus = mGrammarLexer.next({
 			.token = rhs,
 			.source = source,
 			.debug = resultInfo,
 			.initState = token_any,
-		})) {
+		}))) {
 			rhsVec.emplace_back(rhs);
 		}		
+		if (rhsStatus == TKN_ERR) {
+			return failLoad(i + 1, "Unexpected symbol on the right-hand side");
+		}
 		
 		ruleArr.emplace_back(TokRule {
 			.lhs = lhs,
@@ -317,7 +565,76 @@ ParserBuilder& ParserBuilder::loadGrammar(const std::span<const StrRule>& gramma
 		.lookaheadId = token_lexer_end
 	});
 
-	computeAllFirstSets(ruleArr);
-	buildTables(mParser, ruleArr);
+	loadRules(ruleArr);
     return *this;
+}
+
+ParserBuilder& ParserBuilder::loadGrammarFile(const char* path) {
+    std::ifstream stream(path);
+    if (!stream) {
+        return failLoad(0, std::string("Cannot open grammar file ") + path);
+    }
+    return loadGrammarStream(stream);
+}
+
+ParserBuilder& ParserBuilder::loadGrammarStream(std::istream& stream) {
+    TraceScope trace("loadGrammarStream", "builder");
+    std::vector<TokRule> ruleArr;
+    mSymbols.clear();
+    // Only the levels of the previous file go; addPrecedence() ones stay.
+    std::erase_if(mPrecedence, [this](const auto& entry) {
+        return entry.second.level >= mFileLevelFirst && entry.second.level <= mFileLevelLast;
+    });
+    mFileLevelFirst = mPrecedenceLevel + 1;
+    mFileLevelLast = mPrecedenceLevel;
+
+    std::vector<PrecedenceDecl> precedence;
+    GrammarLoader loader(stream, mSymbols);
+    if (loader.load(ruleArr, precedence, mLoadInfo) != TKN_OK) {
+        return failLoad(mLoadInfo.line, mLoadInfo.message);
+    }
+
+    for (const PrecedenceDecl& decl : precedence) {
+        addPrecedence(decl.assoc, decl.terminals);
+    }
+    mFileLevelLast = mPrecedenceLevel;
+    loadRules(ruleArr);
+    return *this;
+}
+
+ParserBuilder& ParserBuilder::failLoad(size_t line, LexerMsg message) {
+    mLoadInfo = { TKN_ERR, line, std::move(message) };
+    // build() must not hand out the tables of an earlier grammar.
+    mParser = Parser();
+    mRules.clear();
+    return *this;
+}
+
+ParserBuilder& ParserBuilder::addPrecedence(PrecAssoc_ assoc, std::span<const TokenID> terminals) {
+    ++mPrecedenceLevel;
+    for (TokenID terminal : terminals) {
+        mPrecedence[terminal] = { mPrecedenceLevel, assoc };
+    }
+    return *this;
+}
+
+void ParserBuilder::loadRules(const std::vector<TokRule>& rules) {
+    TraceScope trace("loadRules", "builder");
+    mRulePrecedence.assign(rules.size(), {});
+    for (size_t i = 0; i < rules.size(); ++i) {
+        TokenID precToken = rules[i].prec;
+        for (auto it = rules[i].rhs.rbegin(); !precToken && it != rules[i].rhs.rend(); ++it) {
+            if (it->info()->category == TokenCategory_term && mPrecedence.count(it->info()->id)) {
+                precToken = it->info()->id;
+            }
+        }
+
+        if (auto it = mPrecedence.find(precToken); precToken && it != mPrecedence.end()) {
+            mRulePrecedence[i] = it->second;
+        }
+    }
+
+    mRules = rules;
+	mFirstSets.compute(rules);
+	buildTables(mParser, rules);
 }
\ No newline at end of file
@@ -3,10 +3,13 @@
 
 #include <initializer_list>
 #include <map>
+#include <memory_resource>
 #include <set>
 #include <ranges>
 #include <span>
 #include <queue>
+#include "FirstSets.hpp"
+#include "GrammarLoader.hpp"
 #include "Lexer.hpp"
 #include "Parser.hpp"
 #include "Lexer.hpp"
@@ -14,8 +17,6 @@
 
 int grammar_lexer_implies(const TokenSwitchArgs& args);
 
-using FirstSet = std::map<TokenID, std::set<TokenID>>;
-
 struct LRItem {
     int ruleIndex{};
     int dotPos{};
@@ -32,13 +33,14 @@ struct LRItem {
     }
 };
 
-using StateSet = std::set<LRItem>;
+using StateSet = std::pmr::set<LRItem>;
 using RuleStrList = std::initializer_list<const char*>;
 
 struct TokRule {
     Token lhs;
     std::vector<Token> rhs;
     RuleTag tag;
+    TokenID prec{};     // terminal whose precedence the rule takes, if not its last one
 };
 
 enum ParserStates {
@@ -55,26 +57,102 @@ struct StrRule {
     RuleTag tag{};
 };
 
+enum ParserBuildFlags_ {
+    ParserBuildFlags_none = 0,
+    ParserBuildFlags_unitElimination = 1 << 0,
+    ParserBuildFlags_defaultReductions = 1 << 1,
+    ParserBuildFlags_compressTables = 1 << 2,
+    ParserBuildFlags_lazyTables = 1 << 3,
+    ParserBuildFlags_stateLexing = 1 << 4,
+};
+
+struct TableStats {
+    size_t bytesBefore{};
+    size_t bytesAfter{};
+    size_t conflicts{};     // shift/reduce and reduce/reduce conflicts left to the defaults
+};
+
 class ParserBuilder {
 public:
     ParserBuilder& initGrammarLexer();
     Lexer& getGrammarLexer() {
         return mGrammarLexer;
     }
+    ParserBuilder& withFlags(int flags) {
+        mFlags = flags;
+        return *this;
+    }
+    // Numbers states and orders compressed columns by a profile taken from a
+    // build of the same grammar and flags; it must outlive the builds that
+    // use it. Lazy tables ignore it.
+    ParserBuilder& withProfile(const TransitionProfile* profile) {
+        mProfile = profile;
+        return *this;
+    }
+    // Item sets, state indices and worklists of table generation allocate
+    // from the resource, e.g. a monotonic arena released after build(). The
+    // tables themselves use the default resource, as they outlive the build.
+    ParserBuilder& withMemoryResource(std::pmr::memory_resource* resource) {
+        mResource = resource;
+        return *this;
+    }
+    ParserBuilder& addPrecedence(PrecAssoc_ assoc, std::span<const TokenID> terminals);
+    ParserBuilder& addPrecedence(PrecAssoc_ assoc, std::initializer_list<TokenID> terminals) {
+        return addPrecedence(assoc, std::span<const TokenID>(terminals.begin(), terminals.size()));
+    }
     ParserBuilder& loadGrammar(const std::span<const StrRule>& grammar);
+    // A grammar file declares its own precedence: loading one drops the
+    // levels of the previous file but keeps those of addPrecedence().
+    ParserBuilder& loadGrammarFile(const char* path);
+    ParserBuilder& loadGrammarStream(std::istream& stream);
     Parser build() {
         return std::move(mParser);
     }
+    const TableStats& getTableStats() const {
+        return mTableStats;
+    }
+    const FirstSets& getFirstSets() const {
+        return mFirstSets;
+    }
+    const GrammarSymbols& getSymbols() const {
+        return mSymbols;
+    }
+    const GrammarLoadInfo& getLoadInfo() const {
+        return mLoadInfo;
+    }
+    // Rules of the last loaded grammar, rule 0 being the augmented start.
+    const std::vector<TokRule>& getGrammar() const {
+        return mRules;
+    }
 private:
-    std::set<TokenID> computeFirst(const TokRule& rule, int startIdx, TokenID currentLookahead);
-    void computeAllFirstSets(const std::vector<TokRule>& rules);
+    class LazyGrammar;
+
     void computeClosure(StateSet& set, const std::vector<TokRule>& rules);
     StateSet computeGoto(const StateSet& items, TokenID symbolId, const std::vector<TokRule>& rules);
+    template <typename StateOf>
+    void buildRow(const StateSet& set, const std::vector<TokRule>& rules, StateOf&& stateOf, std::unordered_map<TokenID, Action>& actionRow, std::unordered_map<TokenID, TokenID>& gotoRow);
     void buildTables(Parser& parser, const std::vector<TokRule>& rules);
+    void addAction(std::unordered_map<TokenID, Action>& actionRow, TokenID lookahead, const Action& action);
+    void loadRules(const std::vector<TokRule>& rules);
+    ParserBuilder& failLoad(size_t line, LexerMsg message);
+    void eliminateUnitRules(ActionTable& actionTable, GotoTable& gotoTable, const std::vector<TokRule>& rules, ParserState stateCount);
+    DefaultReduceTable computeDefaultReductions(const ActionTable& actionTable);
 private:
     Parser mParser;
     Lexer mGrammarLexer;
-    FirstSet mFirstSets;
+    FirstSets mFirstSets;
+    int mFlags = ParserBuildFlags_none;
+    const TransitionProfile* mProfile{};
+    std::pmr::memory_resource* mResource = std::pmr::get_default_resource();
+    TableStats mTableStats;
+    GrammarSymbols mSymbols;
+    PrecedenceTable mPrecedence;
+    std::vector<Precedence> mRulePrecedence;
+    int mPrecedenceLevel{};
+    int mFileLevelFirst = 1;    // levels declared by the last grammar file
+    int mFileLevelLast{};
+    GrammarLoadInfo mLoadInfo;
+    std::vector<TokRule> mRules;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,60 @@
+#ifndef PARSER_DEFS
+#define PARSER_DEFS
+
+#include "Lexer.hpp"
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
+
+enum ParserActType_ { 
+    ParserActType_shift,
+    ParserActType_reduce,
+    ParserActType_accept,
+    ParserActType_error
+};
+
+enum ParseStatus_ {
+    ParseStatus_ok,
+    ParseStatus_skip = -3,
+    ParseStatus_finish = -2,
+    ParseStatus_err = -1
+};
+
+using RuleTag = long long;
+using ParserState = long long;
+
+constexpr ParserState ParserState_none = 0; 
+
+struct Action {
+    ParserActType_ type = ParserActType_error;
+    ParserState value = ParserState_none;
+};
+
+struct GrammarRule {
+    TokenID lhsId;     
+    size_t rhsSize;   
+    RuleTag tag;
+};
+
+using ActionTable = std::unordered_map<TokenID, std::unordered_map<TokenID, Action>>;
+using GotoTable = std::unordered_map<TokenID, std::unordered_map<TokenID, TokenID>>;
+using DefaultReduceTable = std::unordered_map<ParserState, ParserState>;
+using ParserStateStack = std::pmr::vector<ParserState>;
+using GrammarRuleList = std::vector<GrammarRule>;
+
+using ReduceList = std::vector<Token>;
+
+enum PrecAssoc_ {
+    PrecAssoc_left,
+    PrecAssoc_right,
+    PrecAssoc_nonassoc
+};
+
+struct Precedence {
+    int level{};
+    PrecAssoc_ assoc = PrecAssoc_left;
+};
+
+using PrecedenceTable = std::unordered_map<TokenID, Precedence>;
+
+#endif
@@ -0,0 +1,282 @@
+#include "SentenceGenerator.hpp"
+#include <cctype>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+
+SentenceGenerator::SentenceGenerator(std::span<const TokRule> rules, const SentenceOptions& options)
+    : mOptions(options), mRng(options.seed) {
+    std::unordered_map<TokenID, uint32_t> index;
+    auto symbolOf = [&](const Token& token) {
+        auto [it, inserted] = index.try_emplace(token.info()->id, (uint32_t)mSymbols.size());
+        if (inserted) {
+            mSymbols.push_back(GenSymbol { .id = token.info()->id, .spelling = token.value() });
+        }
+        return it->second;
+    };
+
+    mRules.reserve(rules.size());
+    for (const TokRule& rule : rules) {
+        GenRule& genRule = mRules.emplace_back(GenRule { .lhs = symbolOf(rule.lhs) });
+        mSymbols[genRule.lhs].nonterminal = true;
+        mSymbols[genRule.lhs].rules.push_back((uint32_t)mRules.size() - 1);
+
+        for (const Token& sym : rule.rhs) {
+            genRule.rhs.push_back(symbolOf(sym));
+        }
+    }
+
+    for (GenSymbol& symbol : mSymbols) {
+        if (symbol.nonterminal) {
+            continue;
+        }
+
+        // Literals count with their average length, so that sentences land
+        // close to the target rather than past it.
+        symbol.height = 0;
+        switch (symbol.id) {
+            case token_integer:
+                symbol.shortBytes = 5;
+                break;
+            case token_id:
+                symbol.shortBytes = 6;
+                break;
+            case token_real:
+                symbol.shortBytes = 7;
+                break;
+            default:
+                symbol.shortBytes = symbol.spelling.size() + 1;
+                if (!symbol.spelling.empty() && isalpha((unsigned char)symbol.spelling[0])) {
+                    mKeywords.insert(symbol.spelling);
+                }
+        }
+    }
+
+    computeMinimum(true, &GenSymbol::shortBytes, &GenRule::shortBytes);
+    computeMinimum(false, &GenSymbol::height, &GenRule::height);
+
+    for (GenSymbol& symbol : mSymbols) {
+        if (!symbol.rules.empty()) {
+            symbol.shallowestRule = symbol.rules.front();
+        }
+        for (uint32_t rule : symbol.rules) {
+            if (mRules[rule].height < mRules[symbol.shallowestRule].height) {
+                symbol.shallowestRule = rule;
+            }
+        }
+    }
+
+    if (!rules.empty()) {
+        mStart = mRules.front().lhs;
+    }
+    restart();
+}
+
+// Knuth's generalization of Dijkstra's algorithm: a rule's cost is known once
+// its nonterminals' are, and a nonterminal's is final when it leaves the
+// queue. Costs add up along a rule, or take the deepest symbol plus one.
+void SentenceGenerator::computeMinimum(bool additive, size_t GenSymbol::* symbolCost, size_t GenRule::* ruleCost) {
+    std::vector<std::vector<uint32_t>> uses(mSymbols.size());
+    std::vector<uint32_t> waiting(mRules.size());
+    std::vector<bool> done(mSymbols.size());
+
+    using Entry = std::pair<size_t, uint32_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<>> queue;
+
+    auto settle = [&](uint32_t ruleIdx) {
+        GenRule& rule = mRules[ruleIdx];
+        size_t cost = 0;
+        for (uint32_t sym : rule.rhs) {
+            size_t symCost = mSymbols[sym].*symbolCost;
+            cost = additive ? cost + symCost : std::max(cost, symCost);
+        }
+        rule.*ruleCost = additive ? cost : cost + 1;
+        queue.emplace(rule.*ruleCost, rule.lhs);
+    };
+
+    for (uint32_t ruleIdx = 0; ruleIdx < mRules.size(); ++ruleIdx) {
+        for (uint32_t sym : mRules[ruleIdx].rhs) {
+            if (mSymbols[sym].nonterminal) {
+                uses[sym].push_back(ruleIdx);
+                ++waiting[ruleIdx];
+            }
+        }
+        if (!waiting[ruleIdx]) {
+            settle(ruleIdx);
+        }
+    }
+
+    while (!queue.empty()) {
+        auto [cost, sym] = queue.top();
+        queue.pop();
+        if (done[sym]) {
+            continue;
+        }
+
+        done[sym] = true;
+        mSymbols[sym].*symbolCost = cost;
+        for (uint32_t ruleIdx : uses[sym]) {
+            if (--waiting[ruleIdx] == 0) {
+                settle(ruleIdx);
+            }
+        }
+    }
+}
+
+void SentenceGenerator::restart() {
+    mStack.clear();
+    mPendingBytes = 0;
+    mEmitted = 0;
+
+    if (!mSymbols.empty() && mSymbols[mStart].shortBytes != SentenceGenerator_unreachable) {
+        mStack.push_back({ mStart, 0 });
+        mPendingBytes = mSymbols[mStart].shortBytes;
+    }
+}
+
+bool SentenceGenerator::next(std::string& out) {
+    while (!mStack.empty()) {
+        Pending top = mStack.back();
+        mStack.pop_back();
+
+        const GenSymbol& symbol = mSymbols[top.symbol];
+        mPendingBytes -= symbol.shortBytes;
+
+        if (!symbol.nonterminal) {
+            size_t before = out.size();
+            appendTerminal(symbol, out);
+            mEmitted += out.size() - before;
+            return true;
+        }
+
+        const GenRule& rule = mRules[chooseRule(symbol, top.depth)];
+        for (auto it = rule.rhs.rbegin(); it != rule.rhs.rend(); ++it) {
+            mStack.push_back({ *it, top.depth + 1 });
+            mPendingBytes += mSymbols[*it].shortBytes;
+        }
+    }
+    return false;
+}
+
+uint32_t SentenceGenerator::chooseRule(const GenSymbol& symbol, uint32_t depth) {
+    bool grow = (!mOptions.maxDepth || depth < mOptions.maxDepth)
+        && mEmitted + mPendingBytes + symbol.shortBytes < mOptions.targetSize;
+    if (!grow) {
+        return symbol.shallowestRule;
+    }
+
+    // Half of the time only alternatives deeper than the shallowest one are
+    // drawn, otherwise most sentences would end long before the target.
+    bool growingOnly = mRng() & 1;
+    mCandidates.clear();
+    for (uint32_t rule : symbol.rules) {
+        size_t height = mRules[rule].height;
+        if (height != SentenceGenerator_unreachable && (!growingOnly || height > symbol.height)) {
+            mCandidates.push_back(rule);
+        }
+    }
+
+    if (mCandidates.empty()) {
+        return symbol.shallowestRule;
+    }
+    return mCandidates[mRng() % mCandidates.size()];
+}
+
+void SentenceGenerator::appendTerminal(const GenSymbol& symbol, std::string& out) {
+    switch (symbol.id) {
+        case token_integer:
+            out += std::to_string(mRng() % 10000);
+            break;
+        case token_real:
+            out += std::to_string(mRng() % 1000);
+            out += '.';
+            out += std::to_string(mRng() % 100);
+            break;
+        case token_id: {
+            size_t start = out.size();
+            size_t len = 1 + mRng() % 8;
+            for (size_t i = 0; i < len; ++i) {
+                out += char('a' + mRng() % 26);
+            }
+            while (mKeywords.count(out.substr(start))) {
+                out += char('a' + mRng() % 26);
+            }
+            break;
+        }
+        default:
+            out += symbol.spelling;
+    }
+    out += ' ';
+}
+
+size_t SentenceGenerator::write(std::ostream& stream) {
+    constexpr size_t flushSize = 1 << 16;
+
+    std::string buf;
+    size_t written = 0;
+    while (next(buf)) {
+        if (buf.size() >= flushSize) {
+            stream.write(buf.data(), buf.size());
+            written += buf.size();
+            buf.clear();
+        }
+    }
+
+    stream.write(buf.data(), buf.size());
+    return written + buf.size();
+}
+
+size_t SentenceGenerator::writeCorpus(std::ostream& stream, size_t corpusSize) {
+    size_t written = 0;
+    while (written < corpusSize && stream) {
+        restart();
+        written += write(stream);
+        stream.put('\n');
+        ++written;
+    }
+    return written;
+}
+
+bool SentenceSource::fill() {
+    size_t consumed = mPos - mBase;
+    if (consumed > 2 * SentenceSource_window) {
+        mBuf.erase(0, consumed - SentenceSource_window);
+        mBase += consumed - SentenceSource_window;
+    }
+    return mGenerator.next(mBuf);
+}
+
+int SentenceSource::peekChar(char& ch) {
+    while (mPos - mBase >= mBuf.size()) {
+        if (!fill()) {
+            return TKN_FINISH;
+        }
+    }
+
+    ch = mBuf[mPos - mBase];
+    return TKN_OK;
+}
+
+int SentenceSource::nextChar(char& ch) {
+    int status = peekChar(ch);
+    if (status == TKN_OK) {
+        ++mPos;
+    }
+    return status;
+}
+
+size_t SentenceSource::tell() const {
+    return mPos;
+}
+
+bool SentenceSource::seek(size_t pos) {
+    if (pos < mBase) {
+        return false;
+    }
+
+    if (pos > mBase + mBuf.size()) {
+        pos = mBase + mBuf.size();
+    }
+    mPos = pos;
+    return true;
+}
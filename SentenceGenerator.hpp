@@ -0,0 +1,108 @@
+#ifndef SENTENCEGENERATOR_HPP
+#define SENTENCEGENERATOR_HPP
+
+#include "Lexer.hpp"
+#include "ParserBuilder.hpp"
+#include <ostream>
+#include <random>
+#include <span>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+struct SentenceOptions {
+    uint64_t seed{};
+    size_t targetSize = 1 << 10;    // bytes after which alternatives stop growing
+    size_t maxDepth{};              // nesting after which they stop growing, 0 for none
+};
+
+// Random sentences of a grammar, produced one terminal at a time. Below the
+// size and depth limits a nonterminal takes a random alternative, leaning
+// towards the ones that grow; past them it takes the alternative with the
+// shallowest derivation, so every sentence ends. Terminals are separated by
+// spaces, int, real and id get random literals that are not keywords. The
+// same rules, options and seed give the same text.
+class SentenceGenerator {
+public:
+    SentenceGenerator(std::span<const TokRule> rules, const SentenceOptions& options = {});
+
+    // Appends the next terminal to out; false once the sentence is complete.
+    bool next(std::string& out);
+
+    // Starts another sentence, continuing the random sequence.
+    void restart();
+
+    // Writes the rest of the current sentence.
+    size_t write(std::ostream& stream);
+
+    // Writes sentences, one per line, until corpusSize bytes are out.
+    size_t writeCorpus(std::ostream& stream, size_t corpusSize);
+
+    size_t emitted() const {
+        return mEmitted;
+    }
+private:
+    static constexpr size_t SentenceGenerator_unreachable = SIZE_MAX;
+
+    struct GenSymbol {
+        TokenID id{};
+        std::string spelling;
+        bool nonterminal{};
+        std::vector<uint32_t> rules;
+        size_t shortBytes = SentenceGenerator_unreachable;     // about the bytes of its shortest expansion
+        size_t height = SentenceGenerator_unreachable;
+        uint32_t shallowestRule{};
+    };
+
+    struct GenRule {
+        uint32_t lhs{};
+        std::vector<uint32_t> rhs;
+        size_t shortBytes = SentenceGenerator_unreachable;
+        size_t height = SentenceGenerator_unreachable;
+    };
+
+    struct Pending {
+        uint32_t symbol{};
+        uint32_t depth{};
+    };
+
+    void computeMinimum(bool additive, size_t GenSymbol::* symbolCost, size_t GenRule::* ruleCost);
+    uint32_t chooseRule(const GenSymbol& symbol, uint32_t depth);
+    void appendTerminal(const GenSymbol& symbol, std::string& out);
+private:
+    SentenceOptions mOptions;
+    std::vector<GenSymbol> mSymbols;
+    std::vector<GenRule> mRules;
+    std::unordered_set<std::string> mKeywords;
+    uint32_t mStart{};
+
+    std::mt19937_64 mRng;
+    std::vector<Pending> mStack;
+    size_t mPendingBytes{};
+    size_t mEmitted{};
+    std::vector<uint32_t> mCandidates;
+};
+
+// Streams one generated sentence to a lexer, so that inputs of any size can
+// be parsed without holding them. Only a window behind the read position is
+// kept, enough for the lexer to seek back to the start of a token.
+class SentenceSource : public LexerSource {
+public:
+    SentenceSource(SentenceGenerator& generator) : mGenerator(generator) { }
+
+    int peekChar(char& ch) override;
+    int nextChar(char& ch) override;
+    size_t tell() const override;
+    bool seek(size_t pos) override;
+private:
+    bool fill();
+private:
+    static constexpr size_t SentenceSource_window = 1 << 12;
+
+    SentenceGenerator& mGenerator;
+    std::string mBuf;
+    size_t mBase{};
+    size_t mPos{};
+};
+
+#endif
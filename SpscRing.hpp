@@ -0,0 +1,63 @@
+#ifndef SPSCRING_HPP
+#define SPSCRING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// Bounded single-producer/single-consumer queue. Capacity is rounded up to a
+// power of two; head and tail live on separate cache lines.
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        mSlots.resize(size);
+        mMask = size - 1;
+    }
+
+    bool tryPush(T&& value) {
+        size_t tail = mTail.load(std::memory_order_relaxed);
+        if (tail - mHeadCache == mSlots.size()) {
+            mHeadCache = mHead.load(std::memory_order_acquire);
+            if (tail - mHeadCache == mSlots.size()) {
+                return false;
+            }
+        }
+
+        mSlots[tail & mMask] = std::move(value);
+        mTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& value) {
+        size_t head = mHead.load(std::memory_order_relaxed);
+        if (head == mTailCache) {
+            mTailCache = mTail.load(std::memory_order_acquire);
+            if (head == mTailCache) {
+                return false;
+            }
+        }
+
+        value = std::move(mSlots[head & mMask]);
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+private:
+    static constexpr size_t CacheLine = 64;
+
+    std::vector<T> mSlots;
+    size_t mMask{};
+
+    alignas(CacheLine) std::atomic<size_t> mHead{};
+    size_t mTailCache{};
+
+    alignas(CacheLine) std::atomic<size_t> mTail{};
+    size_t mHeadCache{};
+};
+
+#endif
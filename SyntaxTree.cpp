@@ -0,0 +1,110 @@
+#include "SyntaxTree.hpp"
+
+int SyntaxTree::pushTerm(const Token& token) {
+    SyntaxToken tok {
+        .info = token.info(),
+        .textOffset = (uint32_t)mText.size(),
+        .textSize = (uint32_t)token.value().size()
+    };
+    mText += token.value();
+
+    mPending.push_back(SyntaxNode {
+        .tag = token.info() ? (int32_t)token.info()->id : (int32_t)token_none,
+        .childCount = 0,
+        .firstChild = SyntaxNode_leaf,
+        .tokenOffset = (uint32_t)mTokens.size()
+    });
+    mTokens.push_back(tok);
+    return 0;
+}
+
+bool SyntaxTree::pushReduced(const GrammarRule& rule) {
+    if (rule.rhsSize > mPending.size()) {
+        return false;
+    }
+
+    size_t base = mPending.size() - rule.rhsSize;
+    SyntaxNode node {
+        .tag = (int32_t)rule.tag,
+        .childCount = (uint32_t)rule.rhsSize,
+        .firstChild = (uint32_t)mNodes.size(),
+        .tokenOffset = rule.rhsSize ? mPending[base].tokenOffset : (uint32_t)mTokens.size()
+    };
+
+    mNodes.insert(mNodes.end(), mPending.begin() + base, mPending.end());
+    mPending.resize(base);
+    mPending.push_back(node);
+    return true;
+}
+
+bool SyntaxTree::pop() {
+    if (mPending.empty()) {
+        return false;
+    }
+    mPending.pop_back();
+    return true;
+}
+
+bool SyntaxTree::finish() {
+    if (mPending.size() != 1) {
+        return false;
+    }
+
+    mRoot = mNodes.size();
+    mNodes.push_back(mPending.back());
+    mPending.clear();
+    return true;
+}
+
+void SyntaxTree::compact() {
+    if (mRoot == SyntaxNode_leaf) {
+        return;
+    }
+
+    // Lay sibling groups out in preorder of their parents, so a depth-first
+    // walk moves forward through memory.
+    std::vector<SyntaxNode> nodes;
+    nodes.reserve(mNodes.size());
+    nodes.push_back(mNodes[mRoot]);
+
+    std::vector<uint32_t> stack { 0 };
+    while (!stack.empty()) {
+        uint32_t idx = stack.back();
+        stack.pop_back();
+
+        SyntaxNode node = nodes[idx];
+        if (node.isLeaf()) {
+            continue;
+        }
+
+        if (node.childCount == 0) {
+            nodes[idx].firstChild = 0;
+            continue;
+        }
+
+        uint32_t first = nodes.size();
+        nodes.insert(nodes.end(), mNodes.begin() + node.firstChild, mNodes.begin() + node.firstChild + node.childCount);
+        nodes[idx].firstChild = first;
+
+        for (uint32_t i = node.childCount; i > 0; --i) {
+            stack.push_back(first + i - 1);
+        }
+    }
+
+    mNodes = std::move(nodes);
+    mRoot = 0;
+}
+
+void SyntaxTree::clear() {
+    mNodes.clear();
+    mPending.clear();
+    mTokens.clear();
+    mText.clear();
+    mRoot = SyntaxNode_leaf;
+}
+
+void SyntaxTree::reserve(size_t tokenCount) {
+    mTokens.reserve(tokenCount);
+    mNodes.reserve(tokenCount * 2);
+    mPending.reserve(64);
+}
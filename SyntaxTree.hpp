@@ -0,0 +1,85 @@
+#ifndef SYNTAXTREE_HPP
+#define SYNTAXTREE_HPP
+
+#include "Parser.hpp"
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+constexpr uint32_t SyntaxNode_leaf = UINT32_MAX;
+
+struct SyntaxNode {
+    int32_t tag{};          // rule tag, or token id for leaves
+    uint32_t childCount{};
+    uint32_t firstChild{};  // SyntaxNode_leaf for leaves
+    uint32_t tokenOffset{};
+
+    bool isLeaf() const {
+        return firstChild == SyntaxNode_leaf;
+    }
+};
+
+struct SyntaxToken {
+    const TokenInfo* info{};
+    uint32_t textOffset{};
+    uint32_t textSize{};
+};
+
+// Value stack that builds a concrete syntax tree. Nodes, tokens and token text
+// live in three flat arrays; the children of a node are stored contiguously and
+// addressed by index, so the whole tree is released by clear() at once.
+class SyntaxTree final : public ParserValueStack {
+public:
+    SyntaxTree() = default;
+
+    int pushTerm(const Token& token) override;
+    bool pushReduced(const GrammarRule& rule) override;
+    bool pop() override;
+
+    bool finish();
+    void compact();
+    void clear();
+    void reserve(size_t tokenCount);
+
+    const SyntaxNode* root() const {
+        return mRoot == SyntaxNode_leaf ? nullptr : &mNodes[mRoot];
+    }
+
+    std::span<const SyntaxNode> children(const SyntaxNode& node) const {
+        if (node.isLeaf()) {
+            return {};
+        }
+        return std::span<const SyntaxNode>(mNodes.data() + node.firstChild, node.childCount);
+    }
+
+    // First token of the node. Epsilon nodes span none and give an empty
+    // token and text.
+    const SyntaxToken& token(const SyntaxNode& node) const {
+        static const SyntaxToken empty;
+        bool spansNone = !node.isLeaf() && node.childCount == 0;
+        return spansNone || node.tokenOffset >= mTokens.size() ? empty : mTokens[node.tokenOffset];
+    }
+
+    std::string_view text(const SyntaxNode& node) const {
+        const SyntaxToken& tok = token(node);
+        return std::string_view(mText.data() + tok.textOffset, tok.textSize);
+    }
+
+    const std::vector<SyntaxNode>& nodes() const {
+        return mNodes;
+    }
+
+    const std::vector<SyntaxToken>& tokens() const {
+        return mTokens;
+    }
+private:
+    std::vector<SyntaxNode> mNodes;
+    std::vector<SyntaxNode> mPending;
+    std::vector<SyntaxToken> mTokens;
+    std::string mText;
+    uint32_t mRoot = SyntaxNode_leaf;
+};
+
+#endif
@@ -0,0 +1,66 @@
+#include "TableProfile.hpp"
+#include "Parser.hpp"
+#include <algorithm>
+
+void renumberStates(ParserTables& tables, const TransitionProfile& profile) {
+    size_t stateCount = 1;
+    auto seeState = [&](ParserState state) {
+        stateCount = std::max(stateCount, (size_t)state + 1);
+    };
+    for (auto& [state, row] : tables.actionTable) {
+        seeState(state);
+        for (auto& [tokenId, action] : row) {
+            if (action.type == ParserActType_shift) {
+                seeState(action.value);
+            }
+        }
+    }
+    for (auto& [state, row] : tables.gotoTable) {
+        seeState(state);
+        for (auto& [symbolId, target] : row) {
+            seeState(target);
+        }
+    }
+
+    std::vector<ParserState> order(stateCount);
+    for (size_t state = 0; state < stateCount; ++state) {
+        order[state] = (ParserState)state;
+    }
+    std::stable_sort(order.begin() + 1, order.end(), [&](ParserState a, ParserState b) {
+        return profile.states.get(a) > profile.states.get(b);
+    });
+
+    std::vector<ParserState> newState(stateCount);
+    for (size_t i = 0; i < stateCount; ++i) {
+        newState[order[i]] = (ParserState)i;
+    }
+
+    ActionTable actionTable;
+    for (auto& [state, row] : tables.actionTable) {
+        auto& newRow = actionTable[newState[state]];
+        for (auto& [tokenId, action] : row) {
+            Action moved = action;
+            if (moved.type == ParserActType_shift) {
+                moved.value = newState[moved.value];
+            }
+            newRow.emplace(tokenId, moved);
+        }
+    }
+
+    GotoTable gotoTable;
+    for (auto& [state, row] : tables.gotoTable) {
+        auto& newRow = gotoTable[newState[state]];
+        for (auto& [symbolId, target] : row) {
+            newRow.emplace(symbolId, newState[target]);
+        }
+    }
+
+    DefaultReduceTable defaultReductions;
+    for (auto& [state, rule] : tables.defaultReductions) {
+        defaultReductions.emplace(newState[state], rule);
+    }
+
+    tables.actionTable = std::move(actionTable);
+    tables.gotoTable = std::move(gotoTable);
+    tables.defaultReductions = std::move(defaultReductions);
+}
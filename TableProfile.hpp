@@ -0,0 +1,32 @@
+#ifndef TABLEPROFILE_HPP
+#define TABLEPROFILE_HPP
+
+#include "ParseStats.hpp"
+#include "ParserDefs.hpp"
+
+struct ParserTables;
+
+// How often a parse visited each state and looked up each symbol, gathered
+// with Parser::setProfile over a representative corpus. Handed to
+// ParserBuilder::withProfile for a build of the same grammar and flags, it
+// numbers hot states first and puts hot columns next to each other.
+struct TransitionProfile {
+    StatCounts states;
+    StatCounts symbols;
+
+    void merge(const TransitionProfile& other) {
+        states.merge(other.states);
+        symbols.merge(other.symbols);
+    }
+
+    void clear() {
+        states.clear();
+        symbols.clear();
+    }
+};
+
+// Renumbers the states of eager tables by falling visit count. State 0 stays
+// the start state, ties keep their order.
+void renumberStates(ParserTables& tables, const TransitionProfile& profile);
+
+#endif
@@ -0,0 +1,64 @@
+#include "TerminalMasks.hpp"
+#include <algorithm>
+
+size_t appendTerminalMask(const std::unordered_map<TokenID, Action>& row, std::vector<uint64_t>& bits, TerminalMask& mask) {
+    mask = {};
+
+    TokenID minId = 0;
+    TokenID maxId = -1;
+    for (auto& [tokenId, action] : row) {
+        if (tokenId < 0) {
+            continue;
+        }
+        if (tokenId < 64) {
+            mask.builtin |= uint64_t(1) << tokenId;
+            continue;
+        }
+        if (maxId < minId) {
+            minId = maxId = tokenId;
+        } else {
+            minId = std::min(minId, tokenId);
+            maxId = std::max(maxId, tokenId);
+        }
+    }
+
+    size_t offset = bits.size();
+    if (maxId < minId) {
+        return offset;
+    }
+
+    mask.base = minId;
+    mask.count = maxId - minId + 1;
+    bits.resize(offset + (size_t)((mask.count + 63) >> 6));
+
+    for (auto& [tokenId, action] : row) {
+        if (tokenId >= 64) {
+            TokenID bit = tokenId - minId;
+            bits[offset + (bit >> 6)] |= uint64_t(1) << (bit & 63);
+        }
+    }
+    return offset;
+}
+
+TerminalMasks::TerminalMasks(const ActionTable& actionTable) {
+    size_t stateCount = 0;
+    for (auto& [state, row] : actionTable) {
+        stateCount = std::max(stateCount, (size_t)state + 1);
+    }
+
+    mMasks.resize(stateCount);
+    std::vector<size_t> offsets(stateCount);
+    for (auto& [state, row] : actionTable) {
+        offsets[state] = appendTerminalMask(row, mBits, mMasks[state]);
+    }
+
+    for (size_t state = 0; state < stateCount; ++state) {
+        if (mMasks[state].count) {
+            mMasks[state].custom = mBits.data() + offsets[state];
+        }
+    }
+}
+
+size_t TerminalMasks::bytes() const {
+    return sizeof(*this) + mMasks.capacity() * sizeof(TerminalMask) + mBits.capacity() * sizeof(uint64_t);
+}
@@ -0,0 +1,33 @@
+#ifndef TERMINALMASKS_HPP
+#define TERMINALMASKS_HPP
+
+#include "ParserDefs.hpp"
+#include <unordered_map>
+#include <vector>
+
+// Sets mask to the terminals of an action row. The bits of its custom span
+// are appended to bits; the caller points mask.custom at them, at the
+// returned offset, once bits has stopped growing.
+size_t appendTerminalMask(const std::unordered_map<TokenID, Action>& row, std::vector<uint64_t>& bits, TerminalMask& mask);
+
+// The terminals each state has an action for, so that the lexer only looks
+// for tokens the parser can take next.
+class TerminalMasks {
+public:
+    explicit TerminalMasks(const ActionTable& actionTable);
+    TerminalMasks(const TerminalMasks&) = delete;
+
+    const TerminalMask* find(ParserState state) const {
+        if (state < 0 || state >= (ParserState)mMasks.size()) {
+            return nullptr;
+        }
+        return &mMasks[state];
+    }
+
+    size_t bytes() const;
+private:
+    std::vector<TerminalMask> mMasks;
+    std::vector<uint64_t> mBits;
+};
+
+#endif
@@ -0,0 +1,186 @@
+#include "Tracer.hpp"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TraceEvent {
+    const char* name{};
+    const char* category{};
+    char phase{};
+    int64_t begin{};
+    int64_t end{};
+    long long value{};
+};
+
+struct ThreadTrace {
+    std::mutex mutex;
+    uint32_t tid{};
+    std::string name;
+    std::vector<TraceEvent> events;
+    size_t dropped{};
+    uint32_t counters[TraceSample_count] {};
+};
+
+struct TraceState {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadTrace>> threads;
+    std::atomic<uint32_t> sampling[TraceSample_count] {};
+    std::atomic<size_t> maxEvents{};
+    std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+};
+
+TraceState& state() {
+    static TraceState state;
+    return state;
+}
+
+// Registered on the thread's first event and kept after it exits, so that
+// short-lived workers still show up in the trace.
+ThreadTrace& localTrace() {
+    thread_local std::shared_ptr<ThreadTrace> trace;
+    if (!trace) {
+        TraceState& all = state();
+        std::lock_guard lock(all.mutex);
+        trace = std::make_shared<ThreadTrace>();
+        trace->tid = (uint32_t)all.threads.size() + 1;
+        all.threads.push_back(trace);
+    }
+    return *trace;
+}
+
+void record(const TraceEvent& event) {
+    ThreadTrace& trace = localTrace();
+    std::lock_guard lock(trace.mutex);
+    if (trace.events.size() >= state().maxEvents.load(std::memory_order_relaxed)) {
+        ++trace.dropped;
+        return;
+    }
+    trace.events.push_back(event);
+}
+
+void writeString(std::ostream& stream, const char* text) {
+    stream << '"';
+    for (; *text; ++text) {
+        if (*text == '"' || *text == '\\') {
+            stream << '\\';
+        }
+        if ((unsigned char)*text >= 0x20) {
+            stream << *text;
+        }
+    }
+    stream << '"';
+}
+
+void writeMicros(std::ostream& stream, int64_t nanos) {
+    stream << nanos / 1000 << '.';
+    int64_t frac = nanos % 1000;
+    stream << char('0' + frac / 100) << char('0' + frac / 10 % 10) << char('0' + frac % 10);
+}
+
+}
+
+void Tracer::start(const TraceOptions& options) {
+    TraceState& all = state();
+    for (int kind = 0; kind < TraceSample_count; ++kind) {
+        all.sampling[kind].store(options.sampling[kind], std::memory_order_relaxed);
+    }
+    all.maxEvents.store(options.maxEventsPerThread, std::memory_order_relaxed);
+    sEnabled.store(true, std::memory_order_release);
+}
+
+void Tracer::stop() {
+    sEnabled.store(false, std::memory_order_release);
+}
+
+void Tracer::clear() {
+    TraceState& all = state();
+    std::lock_guard lock(all.mutex);
+    for (auto& trace : all.threads) {
+        std::lock_guard threadLock(trace->mutex);
+        trace->events.clear();
+        trace->dropped = 0;
+    }
+}
+
+bool Tracer::sample(TraceSample_ kind) {
+    uint32_t rate = state().sampling[kind].load(std::memory_order_relaxed);
+    if (!rate) {
+        return false;
+    }
+
+    ThreadTrace& trace = localTrace();
+    if (++trace.counters[kind] < rate) {
+        return false;
+    }
+    trace.counters[kind] = 0;
+    return true;
+}
+
+int64_t Tracer::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - state().origin).count();
+}
+
+void Tracer::complete(const char* name, const char* category, int64_t begin, int64_t end) {
+    record({ name, category, 'X', begin, end });
+}
+
+void Tracer::instant(const char* name, const char* category, long long value) {
+    int64_t at = now();
+    record({ name, category, 'i', at, at, value });
+}
+
+void Tracer::nameThread(const char* name) {
+    ThreadTrace& trace = localTrace();
+    std::lock_guard lock(trace.mutex);
+    trace.name = name;
+}
+
+size_t Tracer::eventCount() {
+    TraceState& all = state();
+    std::lock_guard lock(all.mutex);
+
+    size_t count = 0;
+    for (auto& trace : all.threads) {
+        std::lock_guard threadLock(trace->mutex);
+        count += trace->events.size();
+    }
+    return count;
+}
+
+void Tracer::writeJson(std::ostream& stream) {
+    TraceState& all = state();
+    std::lock_guard lock(all.mutex);
+
+    stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    const char* sep = "\n";
+    for (auto& trace : all.threads) {
+        std::lock_guard threadLock(trace->mutex);
+
+        std::string name = trace->name.empty() ? "thread " + std::to_string(trace->tid) : trace->name;
+        stream << sep << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << trace->tid << ",\"args\":{\"name\":";
+        writeString(stream, name.c_str());
+        stream << ",\"dropped\":" << trace->dropped << "}}";
+        sep = ",\n";
+
+        for (const TraceEvent& event : trace->events) {
+            stream << sep << "{\"name\":";
+            writeString(stream, event.name);
+            stream << ",\"cat\":";
+            writeString(stream, event.category);
+            stream << ",\"ph\":\"" << event.phase << "\",\"pid\":1,\"tid\":" << trace->tid << ",\"ts\":";
+            writeMicros(stream, event.begin);
+            if (event.phase == 'X') {
+                stream << ",\"dur\":";
+                writeMicros(stream, event.end - event.begin);
+            } else {
+                stream << ",\"s\":\"t\",\"args\":{\"value\":" << event.value << '}';
+            }
+            stream << '}';
+        }
+    }
+    stream << "\n]}\n";
+}
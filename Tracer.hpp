@@ -0,0 +1,86 @@
+#ifndef TRACER_HPP
+#define TRACER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+enum TraceSample_ {
+    TraceSample_token,
+    TraceSample_reduce,
+    TraceSample_closure,
+    TraceSample_count
+};
+
+struct TraceOptions {
+    // Every Nth event of each sampled kind is recorded, 0 records none.
+    uint32_t sampling[TraceSample_count] {};
+    size_t maxEventsPerThread = 1 << 20;
+};
+
+// Process-wide recorder of Chrome/Perfetto trace events. Each thread
+// appends to its own buffer and is its own track; writeJson() merges them
+// into the trace-event format that chrome://tracing and ui.perfetto.dev
+// load. While stopped every entry point costs one relaxed load.
+class Tracer {
+public:
+    static void start(const TraceOptions& options = {});
+    static void stop();
+    static void clear();
+
+    static bool enabled() {
+        return sEnabled.load(std::memory_order_relaxed);
+    }
+
+    // Counts an event of the given kind on this thread; true when it is one
+    // the sampling rate keeps.
+    static bool sample(TraceSample_ kind);
+
+    static int64_t now();
+    static void complete(const char* name, const char* category, int64_t begin, int64_t end);
+    static void instant(const char* name, const char* category, long long value);
+    static void nameThread(const char* name);
+
+    static size_t eventCount();
+    static void writeJson(std::ostream& stream);
+private:
+    static inline std::atomic<bool> sEnabled{};
+};
+
+// Records the time between construction and destruction as a complete
+// event, when tracing is on and, for a sampled kind, the sample is kept.
+// The name and category must outlive the trace, string literals do.
+class TraceScope {
+public:
+    TraceScope(const char* name, const char* category) {
+        if (Tracer::enabled()) {
+            begin(name, category);
+        }
+    }
+
+    TraceScope(const char* name, const char* category, TraceSample_ kind) {
+        if (Tracer::enabled() && Tracer::sample(kind)) {
+            begin(name, category);
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+
+    ~TraceScope() {
+        if (mName) {
+            Tracer::complete(mName, mCategory, mBegin, Tracer::now());
+        }
+    }
+private:
+    void begin(const char* name, const char* category) {
+        mName = name;
+        mCategory = category;
+        mBegin = Tracer::now();
+    }
+private:
+    const char* mName{};
+    const char* mCategory{};
+    int64_t mBegin{};
+};
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef TYPEDVALUESTACK_HPP
+#define TYPEDVALUESTACK_HPP
+
+#include "Parser.hpp"
+#include <span>
+#include <vector>
+
+// Semantic stack that keeps one value per grammar symbol and pops rule.rhsSize
+// values on every reduction. Reductions are dispatched through a table indexed
+// by rule tag; untagged rules pass their first value through.
+template <typename T>
+class TypedValueStack final : public ParserValueStack {
+public:
+    using TermHandler = T (*)(const Token& token);
+    using ReduceHandler = T (*)(std::span<T> values);
+
+    TypedValueStack(TermHandler termHandler = nullptr) : mTermHandler(termHandler) { }
+
+    TypedValueStack& onTerm(TermHandler handler) {
+        mTermHandler = handler;
+        return *this;
+    }
+
+    TypedValueStack& onReduce(RuleTag tag, ReduceHandler handler) {
+        if (tag < 0) {
+            return *this;
+        }
+
+        if ((size_t)tag >= mReduceHandlers.size()) {
+            mReduceHandlers.resize(tag + 1, nullptr);
+        }
+        mReduceHandlers[tag] = handler;
+        return *this;
+    }
+
+    int pushTerm(const Token& token) override {
+        mValues.push_back(mTermHandler ? mTermHandler(token) : T{});
+        return 0;
+    }
+
+    bool pushReduced(const GrammarRule& rule) override {
+        if (rule.rhsSize > mValues.size()) {
+            return false;
+        }
+
+        size_t base = mValues.size() - rule.rhsSize;
+        ReduceHandler handler = nullptr;
+        if (rule.tag >= 0 && (size_t)rule.tag < mReduceHandlers.size()) {
+            handler = mReduceHandlers[rule.tag];
+        }
+
+        if (!handler) {
+            if (rule.rhsSize == 0) {
+                mValues.push_back(T{});
+            } else {
+                mValues.erase(mValues.begin() + base + 1, mValues.end());
+            }
+            return true;
+        }
+
+        T result = handler(std::span<T>(mValues.data() + base, rule.rhsSize));
+        mValues.erase(mValues.begin() + base, mValues.end());
+        mValues.push_back(std::move(result));
+        return true;
+    }
+
+    bool pop() override {
+        if (mValues.empty()) {
+            return false;
+        }
+        mValues.pop_back();
+        return true;
+    }
+
+    const T& top() const {
+        return mValues.back();
+    }
+
+    size_t size() const {
+        return mValues.size();
+    }
+
+    void clear() {
+        mValues.clear();
+    }
+private:
+    TermHandler mTermHandler{};
+    std::vector<ReduceHandler> mReduceHandlers;
+    std::vector<T> mValues;
+};
+
+#endif
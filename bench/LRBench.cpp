@@ -0,0 +1,382 @@
+#include "ExprGrammar.hpp"
+#include <ExprProgram.hpp>
+#include <LexerBuilder.hpp>
+#include <LexerSources.hpp>
+#include <ParserBuilder.hpp>
+#include <TypedValueStack.hpp>
+#include <benchmark/benchmark.h>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Inputs come from fixed seeds, so every run measures the same bytes.
+constexpr unsigned LRBench_seed = 42;
+constexpr size_t LRBench_lexerInputSize = 1 << 20;
+
+enum LexerInput_ {
+	LexerInput_ids,
+	LexerInput_numbers,
+	LexerInput_operators
+};
+
+static std::string makeLexerInput(LexerInput_ kind, size_t size) {
+	std::mt19937 rng(LRBench_seed);
+	std::string text;
+	text.reserve(size + 32);
+
+	const char* alpha = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	const char* ops = "+-*/:;,!@#%^&()[]{}.~><$";
+	std::string_view opChars(ops);
+
+	while (text.size() < size) {
+		switch (kind) {
+			case LexerInput_ids: {
+				size_t len = 1 + rng() % 12;
+				text += alpha[rng() % 52];
+				for (size_t i = 1; i < len; ++i) {
+					text += (rng() % 4) ? alpha[rng() % 52] : char('0' + rng() % 10);
+				}
+				break;
+			}
+			case LexerInput_numbers:
+				text += std::to_string(rng() % 1000000);
+				if (rng() % 2) {
+					text += '.';
+					text += std::to_string(rng() % 10000);
+				}
+				break;
+			case LexerInput_operators:
+				text += opChars[rng() % opChars.size()];
+				break;
+		}
+		text += ' ';
+	}
+	return text;
+}
+
+static void BM_LexerNext(benchmark::State& state) {
+	LexerInput_ kind = (LexerInput_)state.range(0);
+	std::string text = makeLexerInput(kind, LRBench_lexerInputSize);
+	Lexer lexer = LexerBuilder().withDefaultStates().withStandardOperators().build();
+
+	size_t tokens = 0;
+	for (auto _ : state) {
+		StringViewSource src(text);
+		LexerResultInfo resultInfo;
+		Token tok;
+		while (TKN_OK == lexer.next({tok, src, resultInfo})) {
+			++tokens;
+		}
+		benchmark::DoNotOptimize(tok);
+	}
+
+	state.SetBytesProcessed(state.iterations() * text.size());
+	state.SetItemsProcessed(tokens);
+}
+BENCHMARK(BM_LexerNext)
+	->ArgName("input")
+	->Arg(LexerInput_ids)
+	->Arg(LexerInput_numbers)
+	->Arg(LexerInput_operators)
+	->Unit(benchmark::kMillisecond);
+
+// Numeric literals turned into doubles, either by std::stod on each token's
+// text or by the lexer's own decoding.
+static void BM_LexerNumbers(benchmark::State& state) {
+	bool decode = state.range(0);
+	std::string text = makeLexerInput(LexerInput_numbers, LRBench_lexerInputSize);
+	LexerBuilder builder;
+	builder.withDefaultStates().withStandardOperators();
+	if (decode) {
+		builder.withNumberDecoding();
+	}
+	Lexer lexer = builder.build();
+
+	size_t tokens = 0;
+	for (auto _ : state) {
+		StringViewSource src(text);
+		LexerResultInfo resultInfo;
+		Token tok;
+		double sum = 0;
+		while (TKN_OK == lexer.next({tok, src, resultInfo})) {
+			sum += decode ? tok.number() : std::stod(tok.value());
+			++tokens;
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+
+	state.SetBytesProcessed(state.iterations() * text.size());
+	state.SetItemsProcessed(tokens);
+}
+BENCHMARK(BM_LexerNumbers)
+	->ArgName("decode")
+	->Arg(0)
+	->Arg(1)
+	->Unit(benchmark::kMillisecond);
+
+// An arithmetic expression of a given size, generated as it is read so that
+// gigabyte inputs need no buffer. It repeats one chunk and ends on an operand.
+class ExprSource : public LexerSource {
+public:
+	ExprSource(size_t size) : mBody(size / Chunk.size() * Chunk.size()) { }
+
+	int peekChar(char& ch) override {
+		if (mPos > mBody) {
+			return TKN_FINISH;
+		}
+		ch = mPos < mBody ? Chunk[mPos % Chunk.size()] : '1';
+		return TKN_OK;
+	}
+
+	int nextChar(char& ch) override {
+		int status = peekChar(ch);
+		if (status == TKN_OK) {
+			++mPos;
+		}
+		return status;
+	}
+
+	size_t tell() const override {
+		return mPos;
+	}
+
+	bool seek(size_t pos) override {
+		mPos = std::min(pos, mBody + 1);
+		return true;
+	}
+
+	size_t size() const {
+		return mBody + 1;
+	}
+private:
+	static constexpr std::string_view Chunk = "12+345*6-78/9+2.5*";
+
+	size_t mBody{};
+	size_t mPos{};
+};
+
+class CountingValueStack : public ParserValueStack {
+public:
+	int pushTerm(const Token&) override {
+		++mTokens;
+		return 0;
+	}
+
+	bool pushReduced(const GrammarRule&) override {
+		return true;
+	}
+
+	bool pop() override {
+		return true;
+	}
+
+	size_t tokens() const {
+		return mTokens;
+	}
+private:
+	size_t mTokens{};
+};
+
+static void BM_ParserParseNext(benchmark::State& state) {
+	ParserBuilder parserBuilder;
+	Parser parser = parserBuilder.initGrammarLexer().withFlags(state.range(1)).loadGrammar(exprGrammar).build();
+	Lexer lexer = LexerBuilder().withDefaultStates().withStandardOperators().build();
+
+	size_t bytes = 0;
+	size_t tokens = 0;
+	for (auto _ : state) {
+		ExprSource src(state.range(0));
+		CountingValueStack valueStack;
+		LexerResultInfo resultInfo;
+		parser.reset();
+
+		int status = ParseStatus_ok;
+		while (ParseStatus_ok == (status = parser.parseNext({
+			.lexer = lexer,
+			.source = src,
+			.lexerResInfo = resultInfo,
+			.valueStack = valueStack,
+			.startState = 0,
+		})));
+
+		if (status != ParseStatus_finish) {
+			state.SkipWithError("parse failed");
+			break;
+		}
+		bytes += src.size();
+		tokens += valueStack.tokens();
+	}
+
+	state.SetBytesProcessed(bytes);
+	state.SetItemsProcessed(tokens);
+}
+BENCHMARK(BM_ParserParseNext)
+	->ArgNames({"bytes", "flags"})
+	->ArgsProduct({
+		benchmark::CreateRange(1 << 10, 1 << 30, 32),
+		{ ParserBuildFlags_none, ParserBuildFlags_compressTables | ParserBuildFlags_defaultReductions }
+	})
+	->Unit(benchmark::kMillisecond);
+
+// One expression evaluated against changing variables, re-parsed each time
+// or compiled once through an ExprCache.
+static void BM_ExprEvaluate(benchmark::State& state) {
+	bool cached = state.range(0);
+	Parser parser = ParserBuilder().initGrammarLexer().loadGrammar(exprVarGrammar).build();
+	Lexer lexer = LexerBuilder().withDefaultStates().withStandardOperators().withNumberDecoding().build();
+	std::string_view text = "x * 2.5 + y / 4 - x * y + 17";
+
+	ExprHandlers handlers;
+	handlers
+		.onReduce(RuleOpTags_plus, [](std::span<double> v) { return v[0] + v[2]; })
+		.onReduce(RuleOpTags_minus, [](std::span<double> v) { return v[0] - v[2]; })
+		.onReduce(RuleOpTags_mul, [](std::span<double> v) { return v[0] * v[2]; })
+		.onReduce(RuleOpTags_div, [](std::span<double> v) { return v[0] / v[2]; });
+	ExprCache cache(parser, lexer, handlers, { "x", "y" });
+
+	static double variables[2];
+	TypedValueStack<double> valueStack([](const Token& token) {
+		if (token.info()->id == token_id) {
+			return variables[token.value() == "y"];
+		}
+		return token.number();
+	});
+	for (RuleTag tag = RuleOpTags_plus; tag <= RuleOpTags_div; ++tag) {
+		valueStack.onReduce(tag, handlers.reduce[tag]);
+	}
+
+	double sum = 0;
+	for (auto _ : state) {
+		variables[0] += 1;
+		variables[1] = variables[0] * 0.5;
+		if (cached) {
+			sum += cache.find(text)->evaluate(variables);
+			continue;
+		}
+
+		StringViewSource src(text);
+		LexerResultInfo resultInfo;
+		valueStack.clear();
+		parser.reset();
+		while (ParseStatus_ok == parser.parseNext(BasicParserInputArgs<TypedValueStack<double>> {
+			.lexer = lexer,
+			.source = src,
+			.lexerResInfo = resultInfo,
+			.valueStack = valueStack,
+			.startState = 0,
+		}));
+		sum += valueStack.top();
+	}
+	benchmark::DoNotOptimize(sum);
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ExprEvaluate)
+	->ArgName("cached")
+	->Arg(0)
+	->Arg(1);
+
+// An expression over a million rows of two columns, one row at a time or
+// in lane batches.
+static void BM_ExprColumns(benchmark::State& state) {
+	bool columnar = state.range(0);
+	Parser parser = ParserBuilder().initGrammarLexer().loadGrammar(exprVarGrammar).build();
+	Lexer lexer = LexerBuilder().withDefaultStates().withStandardOperators().withNumberDecoding().build();
+
+	ExprHandlers handlers;
+	handlers
+		.onBinary(RuleOpTags_plus, ExprBinary_add)
+		.onBinary(RuleOpTags_minus, ExprBinary_sub)
+		.onBinary(RuleOpTags_mul, ExprBinary_mul)
+		.onBinary(RuleOpTags_div, ExprBinary_div);
+	ExprCache cache(parser, lexer, handlers, { "x", "y" });
+	auto program = cache.find("x * 2.5 + y / 4 - x * y + 17");
+
+	const size_t rows = 1 << 20;
+	std::vector<double> xs(rows);
+	std::vector<double> ys(rows);
+	for (size_t i = 0; i < rows; ++i) {
+		xs[i] = i * 0.5;
+		ys[i] = i % 100 + 1;
+	}
+	std::vector<double> out(rows);
+	const double* columns[] = { xs.data(), ys.data() };
+
+	for (auto _ : state) {
+		if (columnar) {
+			program->evaluateColumns(columns, rows, out.data());
+		} else {
+			for (size_t i = 0; i < rows; ++i) {
+				double values[] = { xs[i], ys[i] };
+				out[i] = program->evaluate(values);
+			}
+		}
+		benchmark::DoNotOptimize(out.data());
+	}
+	state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_ExprColumns)
+	->ArgName("columnar")
+	->Arg(0)
+	->Arg(1)
+	->Unit(benchmark::kMillisecond);
+
+// One precedence level per pair of rules, with its own operator keyword and
+// parentheses at the bottom, the shape of an expression grammar.
+static std::string makeGrammar(int levels) {
+	std::ostringstream grammar;
+	for (int i = 0; i < levels; ++i) {
+		grammar << "e" << i << " -> e" << i << " op" << i << " e" << i + 1 << " @" << i + 1 << " | e" << i + 1 << "\n";
+	}
+	grammar << "e" << levels << " -> int | id | '(' e0 ')'\n";
+	return grammar.str();
+}
+
+static void BM_ParserBuilderLoadGrammar(benchmark::State& state) {
+	std::string text = makeGrammar(state.range(0));
+
+	size_t rules = 0;
+	for (auto _ : state) {
+		std::istringstream grammar(text);
+		ParserBuilder parserBuilder;
+		parserBuilder.withFlags(state.range(1)).loadGrammarStream(grammar);
+		if (parserBuilder.getLoadInfo().status != TKN_OK) {
+			state.SkipWithError(parserBuilder.getLoadInfo().message.c_str());
+			break;
+		}
+		rules = parserBuilder.build().getRules().size();
+	}
+
+	state.counters["rules"] = rules;
+}
+BENCHMARK(BM_ParserBuilderLoadGrammar)
+	->ArgNames({"levels", "flags"})
+	->ArgsProduct({
+		benchmark::CreateRange(4, 64, 2),
+		{ ParserBuildFlags_none, ParserBuildFlags_compressTables, ParserBuildFlags_lazyTables }
+	})
+	->Unit(benchmark::kMillisecond);
+
+// Reports JSON unless another format is asked for, so runs can be stored and
+// compared for regressions.
+int main(int argc, char** argv) {
+	std::vector<char*> args(argv, argv + argc);
+	std::string jsonFormat = "--benchmark_format=json";
+
+	bool hasFormat = false;
+	for (char* arg : args) {
+		hasFormat |= std::string_view(arg).starts_with("--benchmark_format");
+	}
+	if (!hasFormat) {
+		args.push_back(jsonFormat.data());
+	}
+
+	int count = (int)args.size();
+	benchmark::Initialize(&count, args.data());
+	if (benchmark::ReportUnrecognizedArguments(count, args.data())) {
+		return 1;
+	}
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}
@@ -0,0 +1,54 @@
+#include "ExprGrammar.hpp"
+#include <gtest/gtest.h>
+#include <Coroutines.hpp>
+#include <LexerBuilder.hpp>
+#include <ParserBuilder.hpp>
+#include <TypedValueStack.hpp>
+#include <array>
+#include <string_view>
+
+TEST(Coroutines, TokenGeneratorTest) {
+    StringSource src("1343+ 0.434 * gffg/4");
+	Lexer lexer = LexerBuilder().withDefaultStates().withStandardOperators().build();
+
+    std::array<TokenID, 7> expectedTokens = {
+        token_integer,
+        token_plus,
+        token_real,
+        token_mul,
+        token_id,
+        token_div,
+        token_integer
+    };
+
+	size_t i = 0;
+	for (const Token& token : lexTokens(lexer, src)) {
+		ASSERT_LT(i, expectedTokens.size());
+		EXPECT_EQ(expectedTokens[i], token.info()->id);
+		++i;
+	}
+	EXPECT_EQ(expectedTokens.size(), i);
+}
+
+TEST(Coroutines, AsyncSessionTest) {
+	ParserBuilder parserBuilder;
+	Parser parser = parserBuilder.initGrammarLexer().loadGrammar(exprGrammar).build();
+	Lexer lexer = LexerBuilder().withDefaultStates().withStandardOperators().build();
+
+	TypedValueStack<double> valueStack = makeExprEvaluator();
+
+	AsyncParseSession session(parser, lexer, valueStack);
+	ParseTask task = session.run();
+
+	std::string_view input = "2*3+1";
+	for (char ch : input) {
+		EXPECT_FALSE(task.done());
+		session.push(std::span<const char>(&ch, 1));
+	}
+	EXPECT_FALSE(task.done());
+
+	session.close();
+	ASSERT_TRUE(task.done());
+	EXPECT_EQ(FeedStatus_done, task.result());
+	EXPECT_EQ(7.0, valueStack.top());
+}
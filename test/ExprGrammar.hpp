@@ -0,0 +1,102 @@
+#ifndef EXPRGRAMMAR_HPP
+#define EXPRGRAMMAR_HPP
+
+#include <LexerSources.hpp>
+#include <ParserBuilder.hpp>
+#include <TypedValueStack.hpp>
+#include <cmath>
+#include <string>
+#include <string_view>
+
+// Arithmetic grammar shared by the parser tests and benchmarks; the tags
+// name its binary operators.
+enum RuleOpTags {
+	RuleOpTags_none,
+	RuleOpTags_plus,
+	RuleOpTags_minus,
+	RuleOpTags_mul,
+	RuleOpTags_div,
+	RuleOpTags_pow,
+	RuleOpTags_paren
+};
+
+inline const StrRule exprGrammar[] = {
+	{ "S -> E" },
+	{ "E -> E + T", RuleOpTags_plus },
+	{ "E -> E - T", RuleOpTags_minus },
+	{ "E -> T" },
+	{ "T -> T * P", RuleOpTags_mul },
+	{ "T -> T / P", RuleOpTags_div },
+	{ "T -> P" },
+	{ "P -> F ^ P", RuleOpTags_pow },
+	{ "P -> F" },
+	{ "F -> int" },
+	{ "F -> real" }
+};
+
+// The same grammar with parentheses and variables.
+inline const StrRule exprVarGrammar[] = {
+	{ "S -> E" },
+	{ "E -> E + T", RuleOpTags_plus },
+	{ "E -> E - T", RuleOpTags_minus },
+	{ "E -> T" },
+	{ "T -> T * P", RuleOpTags_mul },
+	{ "T -> T / P", RuleOpTags_div },
+	{ "T -> P" },
+	{ "P -> F ^ P", RuleOpTags_pow },
+	{ "P -> F" },
+	{ "F -> ( E )", RuleOpTags_paren },
+	{ "F -> int" },
+	{ "F -> real" },
+	{ "F -> id" }
+};
+
+inline double applyRuleOp(RuleTag tag, double a, double b) {
+	switch (tag) {
+		case RuleOpTags_plus: return a + b;
+		case RuleOpTags_minus: return a - b;
+		case RuleOpTags_mul: return a * b;
+		case RuleOpTags_div: return a / b;
+		case RuleOpTags_pow: return std::pow(a, b);
+	}
+	return 0.0;
+}
+
+inline double tokenNumber(const Token& token) {
+	bool isNumber = token.info()->id == token_integer || token.info()->id == token_real;
+	return isNumber ? std::stod(token.value()) : 0.0;
+}
+
+inline TypedValueStack<double> makeExprEvaluator() {
+	TypedValueStack<double> valueStack(tokenNumber);
+	valueStack
+		.onReduce(RuleOpTags_plus, [](std::span<double> v) { return v[0] + v[2]; })
+		.onReduce(RuleOpTags_minus, [](std::span<double> v) { return v[0] - v[2]; })
+		.onReduce(RuleOpTags_mul, [](std::span<double> v) { return v[0] * v[2]; })
+		.onReduce(RuleOpTags_div, [](std::span<double> v) { return v[0] / v[2]; })
+		.onReduce(RuleOpTags_pow, [](std::span<double> v) { return std::pow(v[0], v[2]); });
+	return valueStack;
+}
+
+// Runs a whole parse of src from the start state.
+inline int parseAll(Parser& parser, Lexer& lexer, LexerSource& src, ParserValueStack& valueStack) {
+	parser.reset();
+	LexerResultInfo resultInfo;
+
+	int status = ParseStatus_ok;
+	while (ParseStatus_ok == (status = parser.parseNext({
+		.lexer = lexer,
+		.source = src,
+		.lexerResInfo = resultInfo,
+		.valueStack = valueStack,
+		.startState = 0,
+	})));
+	return status;
+}
+
+inline int parseAll(Parser& parser, Lexer& lexer, std::string_view text, ParserValueStack& valueStack) {
+	StringViewSource src(text);
+	return parseAll(parser, lexer, src, valueStack);
+}
+
+#endif
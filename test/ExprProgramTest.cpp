@@ -0,0 +1,136 @@
+#include "ExprGrammar.hpp"
+#include <gtest/gtest.h>
+#include <ExprProgram.hpp>
+#include <LexerBuilder.hpp>
+#include <ParserBuilder.hpp>
+#include <cmath>
+#include <string>
+#include <vector>
+
+static ExprHandlers makeHandlers() {
+	ExprHandlers handlers;
+	handlers
+		.onReduce(RuleOpTags_plus, [](std::span<double> v) { return v[0] + v[2]; })
+		.onReduce(RuleOpTags_minus, [](std::span<double> v) { return v[0] - v[2]; })
+		.onReduce(RuleOpTags_mul, [](std::span<double> v) { return v[0] * v[2]; })
+		.onReduce(RuleOpTags_div, [](std::span<double> v) { return v[0] / v[2]; })
+		.onReduce(RuleOpTags_pow, [](std::span<double> v) { return std::pow(v[0], v[2]); })
+		.onReduce(RuleOpTags_paren, [](std::span<double> v) { return v[1]; });
+	return handlers;
+}
+
+TEST(ExprProgram, EvaluateTest) {
+	Parser parser = ParserBuilder().initGrammarLexer().loadGrammar(exprVarGrammar).build();
+	Lexer lexer = LexerBuilder().withDefaultStates().withStandardOperators().withNumberDecoding().build();
+	ExprCache cache(parser, lexer, makeHandlers(), { "x", "y" });
+
+	auto program = cache.find("(x + 1.5) * y - 2 ^ 3 / y");
+	ASSERT_TRUE(program);
+	for (double x : { -2.0, 0.0, 3.25 }) {
+		for (double y : { 1.0, 4.0 }) {
+			double values[] = { x, y };
+			EXPECT_DOUBLE_EQ((x + 1.5) * y - 8 / y, program->evaluate(values));
+		}
+	}
+	EXPECT_TRUE(std::isnan(program->evaluate({})));
+
+	// 2 * 3 folds into one constant and '+' takes no slot: 6, x and the
+	// reduction remain.
+	auto folded = cache.find("2 * 3 + x");
+	ASSERT_TRUE(folded);
+	EXPECT_EQ(3u, folded->size());
+	double values[] = { 1.0, 0.0 };
+	EXPECT_EQ(7.0, folded->evaluate(values));
+
+	EXPECT_FALSE(cache.find("1 + * 2"));
+	EXPECT_FALSE(cache.find("z + 1"));
+}
+
+TEST(ExprProgram, CacheTest) {
+	Parser parser = ParserBuilder().initGrammarLexer().loadGrammar(exprVarGrammar).build();
+	Lexer lexer = LexerBuilder().withDefaultStates().withStandardOperators().build();
+	ExprCache cache(parser, lexer, makeHandlers(), {}, 2);
+
+	auto first = cache.find("b * a + a");
+	ASSERT_TRUE(first);
+	EXPECT_EQ((std::vector<std::string> { "b", "a" }), first->variables());
+
+	cache.find("a - 1");
+	EXPECT_EQ(first, cache.find("b * a + a"));
+	EXPECT_EQ(1u, cache.hits());
+
+	cache.find("a / 2");
+	EXPECT_EQ(2u, cache.size());
+	EXPECT_EQ(first, cache.find("b * a + a"));
+	cache.find("a - 1");
+	EXPECT_EQ(2u, cache.hits());
+	EXPECT_EQ(4u, cache.misses());
+
+	double values[] = { 3.0, 5.0 };
+	EXPECT_EQ(20.0, first->evaluate(values));
+}
+
+TEST(ExprProgram, ColumnsTest) {
+	Parser parser = ParserBuilder().initGrammarLexer().loadGrammar(exprVarGrammar).build();
+	Lexer lexer = LexerBuilder().withDefaultStates().withStandardOperators().withNumberDecoding().build();
+
+	ExprHandlers handlers;
+	handlers
+		.onBinary(RuleOpTags_plus, ExprBinary_add)
+		.onBinary(RuleOpTags_minus, ExprBinary_sub)
+		.onBinary(RuleOpTags_mul, ExprBinary_mul)
+		.onBinary(RuleOpTags_div, ExprBinary_div)
+		.onBinary(RuleOpTags_pow, ExprBinary_pow)
+		.onReduce(RuleOpTags_paren, [](std::span<double> v) { return v[1]; });
+
+	const char* text = "(x + 1.5) * y - x ^ 2 / (y + 3)";
+	ExprCache cache(parser, lexer, handlers, { "x", "y" });
+	ExprCache reference(parser, lexer, makeHandlers(), { "x", "y" });
+	auto program = cache.find(text);
+	auto expected = reference.find(text);
+	ASSERT_TRUE(program);
+	ASSERT_TRUE(expected);
+
+	const size_t rows = 1000;
+	std::vector<double> xs(rows);
+	std::vector<double> ys(rows);
+	for (size_t i = 0; i < rows; ++i) {
+		xs[i] = i * 0.25 - 40;
+		ys[i] = i % 7 + 0.5;
+	}
+
+	std::vector<double> out(rows);
+	const double* columns[] = { xs.data(), ys.data() };
+	ASSERT_TRUE(program->evaluateColumns(columns, rows, out.data()));
+	for (size_t i = 0; i < rows; ++i) {
+		double values[] = { xs[i], ys[i] };
+		EXPECT_EQ(expected->evaluate(values), out[i]);
+		EXPECT_EQ(program->evaluate(values), out[i]);
+	}
+	EXPECT_FALSE(program->evaluateColumns(std::span(columns, 1), rows, out.data()));
+}
+
+TEST(ExprProgram, EpsilonTest) {
+	const StrRule grammar[] = {
+		{ "S -> E" },
+		{ "E -> id P" },
+		{ "P -> + id", RuleOpTags_plus },
+		{ "P -> ", RuleOpTags_plus }
+	};
+
+	Parser parser = ParserBuilder().initGrammarLexer().loadGrammar(grammar).build();
+	Lexer lexer = LexerBuilder().withDefaultStates().withStandardOperators().build();
+	ExprHandlers handlers;
+	handlers.onBinary(RuleOpTags_plus, ExprBinary_add);
+	ExprCache cache(parser, lexer, handlers, { "x", "y" });
+
+	// The empty P folds to 0 and E keeps its first value.
+	auto program = cache.find("x");
+	ASSERT_TRUE(program);
+	double values[] = { 3.0, 4.0 };
+	EXPECT_EQ(3.0, program->evaluate(values));
+
+	auto pair = cache.find("x + y");
+	ASSERT_TRUE(pair);
+	EXPECT_EQ(3.0, pair->evaluate(values));
+}
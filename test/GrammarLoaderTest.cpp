@@ -0,0 +1,251 @@
+#include "ExprGrammar.hpp"
+#include "LexerSources.hpp"
+#include <gtest/gtest.h>
+#include <LexerBuilder.hpp>
+#include <ParserBuilder.hpp>
+#include <TypedValueStack.hpp>
+#include <cmath>
+#include <sstream>
+
+TEST(GrammarLoader, ExprTest) {
+	std::istringstream grammar(R"(
+		# statements print one expression
+		stmt -> "print" expr @print
+		expr -> expr '+' term @add | expr - term @sub
+		      | term
+		term -> term * fact @mul | fact ;
+		fact -> int | real
+		      | '(' expr ')' @paren
+	)");
+
+	ParserBuilder parserBuilder;
+	Parser parser = parserBuilder.loadGrammarStream(grammar).build();
+	ASSERT_EQ(TKN_OK, parserBuilder.getLoadInfo().status) << parserBuilder.getLoadInfo().message;
+
+	const GrammarSymbols& symbols = parserBuilder.getSymbols();
+	ASSERT_TRUE(symbols.find("expr"));
+	EXPECT_EQ(TokenCategory_nonterm, symbols.find("expr")->info.category);
+	EXPECT_EQ(token_plus, symbols.find("+")->info.id);
+	EXPECT_EQ(token_integer, symbols.find("int")->info.id);
+	EXPECT_GE(symbols.find("print")->info.id, GrammarSymbols_firstTerminal);
+	EXPECT_EQ(10u, parser.getRules().size());
+
+	LexerBuilder lexerBuilder;
+	symbols.addTerminals(lexerBuilder.withDefaultStates().withStandardOperators());
+	Lexer lexer = lexerBuilder.build();
+
+	RuleTag tagPrint = symbols.tag("print");
+	RuleTag tagAdd = symbols.tag("add");
+	RuleTag tagSub = symbols.tag("sub");
+	RuleTag tagMul = symbols.tag("mul");
+	RuleTag tagParen = symbols.tag("paren");
+	EXPECT_EQ(5, tagParen);
+
+	TypedValueStack<double> valueStack(tokenNumber);
+	valueStack
+		.onReduce(tagPrint, [](std::span<double> v) { return v[1]; })
+		.onReduce(tagAdd, [](std::span<double> v) { return v[0] + v[2]; })
+		.onReduce(tagSub, [](std::span<double> v) { return v[0] - v[2]; })
+		.onReduce(tagMul, [](std::span<double> v) { return v[0] * v[2]; })
+		.onReduce(tagParen, [](std::span<double> v) { return v[1]; });
+
+	EXPECT_EQ(ParseStatus_finish, parseAll(parser, lexer, "print (2+3)*4 - 1", valueStack));
+	EXPECT_EQ(19, valueStack.top());
+}
+
+TEST(GrammarLoader, OperatorTest) {
+	std::istringstream grammar(R"(
+		cmp -> sum '==' sum @eq | sum '<=' sum @le
+		sum -> sum + int @add | int
+	)");
+
+	ParserBuilder parserBuilder;
+	Parser parser = parserBuilder.loadGrammarStream(grammar).build();
+	ASSERT_EQ(TKN_OK, parserBuilder.getLoadInfo().status) << parserBuilder.getLoadInfo().message;
+
+	const GrammarSymbols& symbols = parserBuilder.getSymbols();
+	LexerBuilder lexerBuilder;
+	symbols.addTerminals(lexerBuilder.withDefaultStates().withStandardOperators());
+	Lexer lexer = lexerBuilder.build();
+
+	TypedValueStack<double> valueStack(tokenNumber);
+	valueStack
+		.onReduce(symbols.tag("eq"), [](std::span<double> v) { return double(v[0] == v[2]); })
+		.onReduce(symbols.tag("le"), [](std::span<double> v) { return double(v[0] <= v[2]); })
+		.onReduce(symbols.tag("add"), [](std::span<double> v) { return v[0] + v[2]; });
+
+	EXPECT_EQ(ParseStatus_finish, parseAll(parser, lexer, "1 + 2 == 3", valueStack));
+	EXPECT_EQ(1, valueStack.top());
+	EXPECT_EQ(ParseStatus_finish, parseAll(parser, lexer, "4<=1+2", valueStack));
+	EXPECT_EQ(0, valueStack.top());
+}
+
+TEST(GrammarLoader, ErrorTest) {
+	ParserBuilder parserBuilder;
+
+	std::istringstream missingArrow("expr term");
+	parserBuilder.loadGrammarStream(missingArrow);
+	EXPECT_EQ(TKN_ERR, parserBuilder.getLoadInfo().status);
+	EXPECT_EQ(1u, parserBuilder.getLoadInfo().line);
+
+	std::istringstream unterminated("expr -> term\nterm -> 'x");
+	parserBuilder.loadGrammarStream(unterminated);
+	EXPECT_EQ(TKN_ERR, parserBuilder.getLoadInfo().status);
+	EXPECT_EQ(2u, parserBuilder.getLoadInfo().line);
+
+	std::istringstream mixed("expr -> 'term' term\nterm -> int");
+	parserBuilder.loadGrammarStream(mixed);
+	EXPECT_EQ(TKN_ERR, parserBuilder.getLoadInfo().status);
+
+	parserBuilder.loadGrammarFile("/nonexistent/grammar.txt");
+	EXPECT_EQ(TKN_ERR, parserBuilder.getLoadInfo().status);
+
+	std::istringstream hugeTag("expr -> int @123456789012345678901234");
+	parserBuilder.loadGrammarStream(hugeTag);
+	EXPECT_EQ(TKN_ERR, parserBuilder.getLoadInfo().status);
+
+	std::istringstream mixedTag("expr -> int @12abc");
+	parserBuilder.loadGrammarStream(mixedTag);
+	EXPECT_EQ(TKN_ERR, parserBuilder.getLoadInfo().status);
+
+	std::istringstream numericTag("expr -> expr '+' int @7 | int");
+	parserBuilder.loadGrammarStream(numericTag);
+	ASSERT_EQ(TKN_OK, parserBuilder.getLoadInfo().status) << parserBuilder.getLoadInfo().message;
+	EXPECT_EQ(7, parserBuilder.getGrammar()[1].tag);
+
+	// A failed load leaves nothing for build() to return.
+	std::istringstream broken("expr term");
+	Parser parser = parserBuilder.loadGrammarStream(broken).build();
+	EXPECT_TRUE(parser.getRules().empty());
+	EXPECT_TRUE(parserBuilder.getGrammar().empty());
+}
+
+TEST(GrammarLoader, LargeGrammarTest) {
+	constexpr int chainLength = 5000;
+
+	// Two alternatives per nonterminal: a keyword followed by the next link,
+	// or nothing.
+	std::stringstream grammar;
+	for (int i = 0; i < chainLength; ++i) {
+		grammar << "a" << i << " -> k" << i;
+		if (i + 1 < chainLength) {
+			grammar << " a" << i + 1;
+		}
+		grammar << " |\n";
+	}
+
+	ParserBuilder parserBuilder;
+	Parser parser = parserBuilder.withFlags(ParserBuildFlags_lazyTables).loadGrammarStream(grammar).build();
+	ASSERT_EQ(TKN_OK, parserBuilder.getLoadInfo().status) << parserBuilder.getLoadInfo().message;
+	EXPECT_EQ(2u * chainLength + 1, parser.getRules().size());
+
+	LexerBuilder lexerBuilder;
+	parserBuilder.getSymbols().addTerminals(lexerBuilder.withDefaultStates().withStandardOperators());
+	Lexer lexer = lexerBuilder.build();
+
+	TypedValueStack<int> valueStack;
+	EXPECT_EQ(ParseStatus_finish, parseAll(parser, lexer, "k0 k1 k2", valueStack));
+	EXPECT_EQ(ParseStatus_err, parseAll(parser, lexer, "k0 k2", valueStack));
+	EXPECT_LT(parser.getTables()->lazy->materializedStates(), 20u);
+}
+
+TEST(GrammarLoader, PrecedenceTest) {
+	std::istringstream grammar(R"(
+		%nonassoc '<'
+		%left '+' '-'
+		%left '*' '/'
+		%right NEG
+		%right '^'
+		expr -> expr '+' expr @add | expr '-' expr @sub
+		      | expr '*' expr @mul | expr '/' expr @div
+		      | expr '^' expr @pow | expr '<' expr @less
+		      | '-' expr %prec NEG @neg
+		      | int | real
+	)");
+
+	ParserBuilder parserBuilder;
+	Parser parser = parserBuilder.loadGrammarStream(grammar).build();
+	ASSERT_EQ(TKN_OK, parserBuilder.getLoadInfo().status) << parserBuilder.getLoadInfo().message;
+	EXPECT_EQ(0u, parserBuilder.getTableStats().conflicts);
+
+	const GrammarSymbols& symbols = parserBuilder.getSymbols();
+	Lexer lexer = LexerBuilder().withDefaultStates().withStandardOperators().build();
+
+	TypedValueStack<double> valueStack(tokenNumber);
+	valueStack
+		.onReduce(symbols.tag("add"), [](std::span<double> v) { return v[0] + v[2]; })
+		.onReduce(symbols.tag("sub"), [](std::span<double> v) { return v[0] - v[2]; })
+		.onReduce(symbols.tag("mul"), [](std::span<double> v) { return v[0] * v[2]; })
+		.onReduce(symbols.tag("div"), [](std::span<double> v) { return v[0] / v[2]; })
+		.onReduce(symbols.tag("pow"), [](std::span<double> v) { return std::pow(v[0], v[2]); })
+		.onReduce(symbols.tag("less"), [](std::span<double> v) { return v[0] < v[2] ? 1.0 : 0.0; })
+		.onReduce(symbols.tag("neg"), [](std::span<double> v) { return -v[1]; });
+
+	auto eval = [&](const char* text) {
+		valueStack.clear();
+		int status = parseAll(parser, lexer, text, valueStack);
+		return status == ParseStatus_finish ? valueStack.top() : NAN;
+	};
+
+	EXPECT_EQ(36.5, eval("5/2+10*5-4^2"));
+	EXPECT_EQ(512, eval("2^3^2"));
+	EXPECT_EQ(-4, eval("-2^2"));
+	EXPECT_EQ(1, eval("10-4-5"));
+	EXPECT_EQ(1, eval("1+1 < 3"));
+	EXPECT_TRUE(std::isnan(eval("1 < 2 < 3")));
+
+	// A second file without declarations gets none of the first one's.
+	std::istringstream undeclared("expr -> expr '+' expr | int");
+	parserBuilder.loadGrammarStream(undeclared);
+	ASSERT_EQ(TKN_OK, parserBuilder.getLoadInfo().status) << parserBuilder.getLoadInfo().message;
+	EXPECT_EQ(1u, parserBuilder.getTableStats().conflicts);
+
+	// Levels from addPrecedence() outlive file loads.
+	std::istringstream reloaded("expr -> expr '+' expr | int");
+	parserBuilder.addPrecedence(PrecAssoc_left, { token_plus }).loadGrammarStream(reloaded);
+	EXPECT_EQ(0u, parserBuilder.getTableStats().conflicts);
+	std::istringstream again("expr -> expr '+' expr | int");
+	parserBuilder.loadGrammarStream(again);
+	EXPECT_EQ(0u, parserBuilder.getTableStats().conflicts);
+}
+
+TEST(GrammarLoader, StateLexingTest) {
+	const char* text = R"(
+		stmts -> stmts stmt | stmt
+		stmt -> print expr ';' @print
+		expr -> expr '+' atom @add | atom
+		atom -> id @var | int
+	)";
+
+	for (int flags : { ParserBuildFlags_none, ParserBuildFlags_compressTables, ParserBuildFlags_lazyTables }) {
+		std::istringstream grammar(text);
+		ParserBuilder plainBuilder;
+		Parser plain = plainBuilder.withFlags(flags).loadGrammarStream(grammar).build();
+
+		grammar.clear();
+		grammar.str(text);
+		ParserBuilder parserBuilder;
+		Parser parser = parserBuilder.withFlags(flags | ParserBuildFlags_stateLexing).loadGrammarStream(grammar).build();
+		ASSERT_EQ(TKN_OK, parserBuilder.getLoadInfo().status) << parserBuilder.getLoadInfo().message;
+
+		LexerBuilder lexerBuilder;
+		parserBuilder.getSymbols().addTerminals(lexerBuilder.withDefaultStates().withStandardOperators());
+		Lexer lexer = lexerBuilder.build();
+
+		const GrammarSymbols& symbols = parserBuilder.getSymbols();
+		TypedValueStack<int> valueStack([](const Token&) { return 0; });
+		valueStack
+			.onReduce(symbols.tag("print"), [](std::span<int> v) { return v[1]; })
+			.onReduce(symbols.tag("add"), [](std::span<int> v) { return v[0] + v[2]; })
+			.onReduce(symbols.tag("var"), [](std::span<int>) { return 1; });
+
+		// print is a keyword where a statement starts and a name inside one.
+		EXPECT_EQ(ParseStatus_finish, parseAll(parser, lexer, "print print + 1;", valueStack)) << flags;
+		EXPECT_EQ(1, valueStack.top());
+		EXPECT_EQ(ParseStatus_finish, parseAll(parser, lexer, "print 1; print print + 2 + print;", valueStack)) << flags;
+
+		EXPECT_EQ(ParseStatus_err, parseAll(plain, lexer, "print print + 1;", valueStack)) << flags;
+		EXPECT_EQ(ParseStatus_err, parseAll(parser, lexer, "print 1 print;", valueStack)) << flags;
+		EXPECT_EQ(ParseStatus_err, parseAll(parser, lexer, "print + 1;", valueStack)) << flags;
+	}
+}
@@ -0,0 +1,91 @@
+#include "ExprGrammar.hpp"
+#include "LexerSources.hpp"
+#include <gtest/gtest.h>
+#include <GrammarRegistry.hpp>
+#include <LexerBuilder.hpp>
+#include <TypedValueStack.hpp>
+
+static int parseText(Parser parser, const char* text, double& result) {
+	StringSource src(text);
+	Lexer lexer = LexerBuilder().withDefaultStates().withStandardOperators().build();
+	LexerResultInfo resultInfo;
+
+	TypedValueStack<double> valueStack = makeExprEvaluator();
+
+	int status = ParseStatus_ok;
+	while (ParseStatus_ok == (status = parser.parseNext({
+		.lexer = lexer,
+		.source = src,
+		.lexerResInfo = resultInfo,
+		.valueStack = valueStack,
+		.startState = 0,
+	})));
+
+	result = valueStack.size() ? valueStack.top() : 0.0;
+	return status;
+}
+
+TEST(GrammarRegistry, ReloadTest) {
+	const StrRule grammarV1[] = {
+		{ "S -> E" },
+		{ "E -> E + T", RuleOpTags_plus },
+		{ "E -> T" },
+		{ "T -> T * F", RuleOpTags_mul },
+		{ "T -> F" },
+		{ "F -> int" }
+	};
+
+	GrammarRegistry registry;
+	registry.reload(grammarV1);
+	registry.wait();
+	EXPECT_EQ(1u, registry.version());
+
+	double result = 0;
+	Parser inFlight = registry.acquire();
+	std::weak_ptr<const ParserTables> oldTables = inFlight.getTables();
+	EXPECT_EQ(ParseStatus_finish, parseText(inFlight, "2+3*4", result));
+	EXPECT_EQ(14, result);
+	EXPECT_EQ(ParseStatus_err, parseText(inFlight, "7-2", result));
+
+	registry.reload(exprGrammar, ParserBuildFlags_compressTables);
+	registry.wait();
+	EXPECT_EQ(2u, registry.version());
+
+	EXPECT_EQ(ParseStatus_finish, parseText(registry.acquire(), "7-2*3", result));
+	EXPECT_EQ(1, result);
+
+	// The parser taken before the swap keeps running on the old grammar.
+	EXPECT_EQ(ParseStatus_err, parseText(inFlight, "7-2", result));
+	EXPECT_FALSE(oldTables.expired());
+
+	inFlight = Parser();
+	registry.waitRetired();
+	EXPECT_TRUE(oldTables.expired());
+}
+
+TEST(GrammarRegistry, FailedReloadTest) {
+	GrammarRegistry registry;
+	registry.reload(exprGrammar);
+	EXPECT_EQ(TKN_OK, registry.wait());
+	EXPECT_EQ(1u, registry.version());
+
+	const StrRule malformed[] = {
+		{ "S E" },
+		{ "E -> int" }
+	};
+
+	registry.reload(std::span<const StrRule>());
+	EXPECT_EQ(TKN_ERR, registry.wait());
+	registry.reload(malformed);
+	EXPECT_EQ(TKN_ERR, registry.wait());
+	EXPECT_EQ(1u, registry.loadInfo().line);
+	EXPECT_EQ(1u, registry.version());
+
+	double result = 0;
+	EXPECT_EQ(ParseStatus_finish, parseText(registry.acquire(), "7-2*3", result));
+	EXPECT_EQ(1, result);
+
+	registry.reload(exprGrammar, ParserBuildFlags_lazyTables);
+	EXPECT_EQ(TKN_OK, registry.wait());
+	EXPECT_EQ(2u, registry.version());
+}
@@ -0,0 +1,45 @@
+#include "ExprGrammar.hpp"
+#include "LexerSources.hpp"
+#include <gtest/gtest.h>
+#include <IncrementalParser.hpp>
+#include <LexerBuilder.hpp>
+#include <ParserBuilder.hpp>
+#include <string>
+
+static double evalIncNode(const IncrementalParser& parser, const IncNode& node) {
+	if (node.isLeaf()) {
+		return std::stod(parser.token(node).value);
+	}
+
+	auto children = parser.children(node);
+	if (children.size() == 1) {
+		return evalIncNode(parser, parser.node(children[0]));
+	}
+
+	return applyRuleOp(node.tag, evalIncNode(parser, parser.node(children[0])), evalIncNode(parser, parser.node(children[2])));
+}
+
+TEST(IncrementalParser, EditTest) {
+	ParserBuilder parserBuilder;
+	Parser parser = parserBuilder.initGrammarLexer().loadGrammar(exprGrammar).build();
+	Lexer lexer = LexerBuilder().withDefaultStates().withStandardOperators().build();
+
+	IncrementalParser incParser(parser, lexer);
+	ASSERT_EQ(ParseStatus_finish, incParser.parse("5/2+10*5-4^2 "));
+	EXPECT_EQ(36.5, evalIncNode(incParser, *incParser.root()));
+
+	ASSERT_EQ(ParseStatus_finish, incParser.edit(4, 2, "20"));
+	EXPECT_EQ("5/2+20*5-4^2 ", incParser.text());
+	EXPECT_EQ(86.5, evalIncNode(incParser, *incParser.root()));
+	EXPECT_LE(incParser.lexedTokens(), 3u);
+	EXPECT_GT(incParser.reusedNodes(), 0u);
+
+	ASSERT_EQ(ParseStatus_finish, incParser.edit(13, 0, "+1.5"));
+	EXPECT_EQ(88.0, evalIncNode(incParser, *incParser.root()));
+
+	EXPECT_EQ(ParseStatus_err, incParser.edit(0, 1, "*"));
+	EXPECT_EQ(nullptr, incParser.root());
+
+	ASSERT_EQ(ParseStatus_finish, incParser.edit(0, 1, "7"));
+	EXPECT_EQ(89.0, evalIncNode(incParser, *incParser.root()));
+}
@@ -3,7 +3,10 @@
 #include "LexerDefs.hpp"
 #include "LexerSources.hpp"
 #include <array>
+#include <climits>
 #include <gtest/gtest.h>
+#include <random>
+#include <vector>
 
 TEST(Lexer, ExprTest) {
     StringSource src("1343+ 0.434 * gffg/4");
@@ -33,4 +36,98 @@ TEST(Lexer, ExprTest) {
 		EXPECT_EQ(expectedTokens[i], token.info()->id);
         ++i;
     }
-}
\ No newline at end of file
+}
+TEST(Lexer, NumberDecodingTest) {
+	StringSource src("1343 0.434 007 12345678901234567 9223372036854775807 9223372036854775808 99999999999999999999 123456789.123456789 3.");
+	Lexer lexer = LexerBuilder().withDefaultStates().withStandardOperators().withNumberDecoding().build();
+
+	LexerResultInfo resultInfo;
+	std::vector<Token> tokens;
+	Token token;
+	while (lexer.next({ token, src, resultInfo }) == TKN_OK) {
+		tokens.push_back(token);
+	}
+	ASSERT_EQ(9u, tokens.size());
+
+	EXPECT_EQ(TokenFlags_number, tokens[0].getFlags());
+	EXPECT_EQ(1343, tokens[0].integer());
+	EXPECT_EQ(1343.0, tokens[0].number());
+	EXPECT_EQ(TokenFlags_number, tokens[1].getFlags());
+	EXPECT_EQ(0.434, tokens[1].number());
+	EXPECT_EQ(7, tokens[2].integer());
+
+	EXPECT_EQ(TokenFlags_number | TokenFlags_inexact, tokens[3].getFlags());
+	EXPECT_EQ(12345678901234567, tokens[3].integer());
+	EXPECT_EQ(LLONG_MAX, tokens[4].integer());
+	EXPECT_FALSE(tokens[4].getFlags() & TokenFlags_overflow);
+	EXPECT_TRUE(tokens[5].getFlags() & TokenFlags_overflow);
+	EXPECT_EQ(LLONG_MAX, tokens[5].integer());
+	EXPECT_EQ(9223372036854775808.0, tokens[5].number());
+	EXPECT_TRUE(tokens[6].getFlags() & TokenFlags_overflow);
+	EXPECT_EQ(1e20, tokens[6].number());
+
+	EXPECT_EQ(TokenFlags_number | TokenFlags_inexact, tokens[7].getFlags());
+	EXPECT_EQ(123456789.123456789, tokens[7].number());
+	EXPECT_EQ(3.0, tokens[8].number());
+
+	std::mt19937_64 rng(7);
+	std::string text;
+	for (int i = 0; i < 2000; ++i) {
+		text += std::to_string(rng() >> (rng() % 64));
+		if (i % 2) {
+			std::string fraction = std::to_string(rng() >> (rng() % 64));
+			text += '.' + std::string(rng() % 4, '0') + fraction;
+		}
+		text += ' ';
+	}
+
+	StringSource randomSrc(text.c_str());
+	LexerResultInfo randomInfo;
+	size_t count = 0;
+	while (lexer.next({ token, randomSrc, randomInfo }) == TKN_OK) {
+		ASSERT_TRUE(token.getFlags() & TokenFlags_number);
+		EXPECT_EQ(std::stod(token.value()), token.number()) << token.value();
+		++count;
+	}
+	EXPECT_EQ(2000u, count);
+}
+
+TEST(Lexer, OperatorTrieTest) {
+	enum { op_eq = 1000, op_le, op_arrow, op_shr_assign, op_ellipsis };
+	Lexer lexer = LexerBuilder()
+		.withDefaultStates()
+		.withStandardOperators()
+		.addOperator("==", op_eq)
+		.addOperator("<=", op_le)
+		.addOperator("->", op_arrow)
+		.addOperator(">>=", op_shr_assign)
+		.addOperator("...", op_ellipsis)
+		.build();
+
+	StringSource src("a==b<=c->d>>=e>>f...g..h - 1");
+	LexerResultInfo resultInfo;
+	Token token;
+	std::vector<TokenID> ids;
+	std::vector<std::string> values;
+	while (lexer.next({ token, src, resultInfo }) == TKN_OK) {
+		ids.push_back(token.info()->id);
+		values.push_back(token.value());
+	}
+
+	std::vector<TokenID> expectedIds {
+		token_id, op_eq, token_id, op_le, token_id, op_arrow, token_id, op_shr_assign, token_id,
+		token_greater, token_greater, token_id, op_ellipsis, token_id, token_dot, token_dot, token_id,
+		token_minus, token_integer
+	};
+	EXPECT_EQ(expectedIds, ids);
+	EXPECT_EQ(">>=", values[7]);
+	EXPECT_EQ("e", values[8]);
+	EXPECT_EQ("h", values[16]);
+
+	// Only '>' is acceptable, so ">>=" gives way to its one-character prefix.
+	TerminalMask greater { .builtin = 1ull << token_greater };
+	StringSource masked(">>=");
+	ASSERT_EQ(TKN_OK, lexer.next({ .token = token, .source = masked, .debug = resultInfo, .expected = &greater }));
+	EXPECT_EQ(token_greater, token.info()->id);
+	EXPECT_EQ(1u, masked.tell());
+}
@@ -0,0 +1,30 @@
+#include "ExprGrammar.hpp"
+#include "LexerSources.hpp"
+#include <gtest/gtest.h>
+#include <LexerBuilder.hpp>
+#include <ParsePipeline.hpp>
+#include <ParserBuilder.hpp>
+#include <TypedValueStack.hpp>
+#include <string>
+
+TEST(ParsePipeline, ExprTest) {
+	ParserBuilder parserBuilder;
+	Parser parser = parserBuilder.initGrammarLexer().loadGrammar(exprGrammar).build();
+	Lexer lexer = LexerBuilder().withDefaultStates().withStandardOperators().build();
+
+	std::string input = "1";
+	for (int i = 0; i < 5000; ++i) {
+		input += "+2*3";
+	}
+
+	ParsePipeline pipeline(parser, lexer, { .batchSize = 64, .ringCapacity = 8 });
+
+	StringSource src(input);
+	TypedValueStack<double> valueStack = makeExprEvaluator();
+	EXPECT_EQ(ParseStatus_finish, pipeline.run(src, valueStack));
+	EXPECT_EQ(1.0 + 5000 * 6.0, valueStack.top());
+
+	StringSource badSrc(input + "+*");
+	TypedValueStack<double> badStack = makeExprEvaluator();
+	EXPECT_EQ(ParseStatus_err, pipeline.run(badSrc, badStack));
+}
@@ -0,0 +1,32 @@
+#include "ExprGrammar.hpp"
+#include <gtest/gtest.h>
+#include <LexerBuilder.hpp>
+#include <ParseSession.hpp>
+#include <ParserBuilder.hpp>
+#include <TypedValueStack.hpp>
+#include <string>
+#include <string_view>
+
+TEST(ParseSession, FragmentTest) {
+	ParserBuilder parserBuilder;
+	Parser parser = parserBuilder.initGrammarLexer().loadGrammar(exprGrammar).build();
+	Lexer lexer = LexerBuilder().withDefaultStates().withStandardOperators().build();
+
+	TypedValueStack<double> byteValues = makeExprEvaluator();
+	TypedValueStack<double> chunkValues = makeExprEvaluator();
+	ParseSession byteSession(parser, lexer, byteValues);
+	ParseSession chunkSession(parser, lexer, chunkValues);
+
+	std::string_view input = "5/2+10*5-4^2";
+	for (char ch : input) {
+		EXPECT_NE(FeedStatus_err, byteSession.feed(std::span<const char>(&ch, 1)));
+	}
+	EXPECT_EQ(FeedStatus_done, byteSession.finish());
+	EXPECT_EQ(36.5, byteValues.top());
+
+	EXPECT_EQ(FeedStatus_needMore, chunkSession.feed(std::span<const char>("1", 1)));
+	EXPECT_EQ(FeedStatus_progress, chunkSession.feed(std::span<const char>("0.5 * 2 +", 9)));
+	EXPECT_EQ(FeedStatus_progress, chunkSession.feed(std::span<const char>(" 3", 2)));
+	EXPECT_EQ(FeedStatus_done, chunkSession.finish());
+	EXPECT_EQ(24.0, chunkValues.top());
+}
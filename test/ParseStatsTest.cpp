@@ -0,0 +1,64 @@
+#include "ExprGrammar.hpp"
+#include <gtest/gtest.h>
+#include <LexerBuilder.hpp>
+#include <ParseStats.hpp>
+#include <sstream>
+#include <thread>
+
+TEST(ParseStats, MergeTest) {
+	ParseStats::reset();
+
+	std::thread worker([] {
+		ParseStats& stats = ParseStats::local();
+		stats.shifts += 3;
+		stats.tokens.add(token_plus, 2);
+		stats.tokens.add(1 << 20);
+		stats.maxStackDepth = 7;
+	});
+	worker.join();
+
+	ParseStats::local().shifts += 1;
+	ParseStats::local().maxStackDepth = 4;
+
+	ParseStats stats = ParseStats::collect();
+	EXPECT_EQ(4u, stats.shifts);
+	EXPECT_EQ(2u, stats.tokens.get(token_plus));
+	EXPECT_EQ(1u, stats.tokens.get(1 << 20));
+	EXPECT_EQ(7u, stats.maxStackDepth);
+
+	std::ostringstream json;
+	stats.writeJson(json);
+	EXPECT_NE(std::string::npos, json.str().find("\"shifts\":4"));
+	EXPECT_NE(std::string::npos, json.str().find("\"tokens\":{\"1\":2,\"1048576\":1}"));
+
+	ParseStats::reset();
+	EXPECT_EQ(0u, ParseStats::collect().shifts);
+}
+
+TEST(ParseStats, ParseTest) {
+	ParserBuilder parserBuilder;
+	Parser parser = parserBuilder.initGrammarLexer().loadGrammar(exprGrammar).build();
+	Lexer lexer = LexerBuilder().withDefaultStates().withStandardOperators().build();
+
+	ParseStats::reset();
+	TypedValueStack<int> valueStack;
+	parseAll(parser, lexer, "1 + 2 * 3 + 4", valueStack);
+
+	ParseStats stats = ParseStats::collect();
+#ifdef LRPARSER_STATS
+	EXPECT_EQ(7u, stats.shifts);
+	EXPECT_EQ(2u, stats.reduces.get(1));
+	EXPECT_EQ(1u, stats.reduces.get(3));
+	EXPECT_EQ(1u, stats.reduces.get(4));
+	EXPECT_EQ(4u, stats.reduces.get(9));
+	EXPECT_GE(stats.skips, 6u);
+	EXPECT_GE(stats.tokens.get(token_integer), 4u);
+	EXPECT_GT(stats.checkerCalls, stats.lexerStateBytes.get(token_integer));
+	EXPECT_EQ(6u, stats.maxStackDepth);
+	EXPECT_GT(stats.stateVisits.get(0), 0u);
+#else
+	EXPECT_EQ(0u, stats.shifts);
+	EXPECT_EQ(0u, stats.checkerCalls);
+	EXPECT_EQ(0u, stats.reduces.get(1));
+#endif
+}
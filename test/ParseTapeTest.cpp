@@ -0,0 +1,49 @@
+#include "ExprGrammar.hpp"
+#include "LexerSources.hpp"
+#include <gtest/gtest.h>
+#include <LexerBuilder.hpp>
+#include <ParseTape.hpp>
+#include <ParserBuilder.hpp>
+#include <TypedValueStack.hpp>
+
+TEST(ParseTape, ReplayTest) {
+	ParserBuilder parserBuilder;
+	Parser parser = parserBuilder.initGrammarLexer().loadGrammar(exprGrammar).build();
+	Lexer lexer = LexerBuilder().withDefaultStates().withStandardOperators().build();
+
+	StringSource src("5/2+10*5-4^2");
+	ParseTape tape(parser);
+	EXPECT_EQ(ParseStatus_finish, tape.record(parser, lexer, src));
+	EXPECT_EQ(11u, tape.tokens().size());
+	EXPECT_EQ(31u, tape.events().size());
+
+	for (int i = 0; i < 2; ++i) {
+		TypedValueStack<double> valueStack = makeExprEvaluator();
+
+		tape.replay(valueStack);
+		EXPECT_EQ(36.5, valueStack.top());
+	}
+}
+
+TEST(ParseTape, TablesTest) {
+	Parser parser = ParserBuilder().initGrammarLexer().loadGrammar(exprGrammar).build();
+	Parser other = ParserBuilder().initGrammarLexer().withFlags(ParserBuildFlags_unitElimination).loadGrammar(exprGrammar).build();
+	Lexer lexer = LexerBuilder().withDefaultStates().withStandardOperators().build();
+
+	ParseTape tape(parser);
+	StringSource src("1+2*3");
+	EXPECT_EQ(ParseStatus_finish, tape.record(parser, lexer, src));
+	size_t recorded = tape.events().size();
+
+	StringSource otherSrc("4*5");
+	EXPECT_EQ(ParseStatus_err, tape.record(other, lexer, otherSrc));
+	EXPECT_EQ(recorded, tape.events().size());
+
+	tape.clear();
+	StringSource cleared("4*5");
+	EXPECT_EQ(ParseStatus_finish, tape.record(other, lexer, cleared));
+
+	TypedValueStack<double> valueStack = makeExprEvaluator();
+	tape.replay(valueStack);
+	EXPECT_EQ(20, valueStack.top());
+}
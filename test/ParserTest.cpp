@@ -1,17 +1,13 @@
+#include "ExprGrammar.hpp"
 #include "LexerSources.hpp"
 #include <gtest/gtest.h>
 #include <LexerBuilder.hpp>
 #include <ParserBuilder.hpp>
+#include <TypedValueStack.hpp>
+#include <cmath>
+#include <memory_resource>
 #include <stack>
-
-enum RuleOpTags {
-	RuleOpTags_none,
-	RuleOpTags_plus,
-	RuleOpTags_minus,
-	RuleOpTags_mul,
-	RuleOpTags_div,
-	RuleOpTags_pow
-};
+#include <thread>
 
 class TestValueStack : public ParserValueStack {
 public:
@@ -76,31 +72,403 @@ private:
 };
 
 TEST(Parser, ExprTest) {
+	ParserBuilder parserBuilder;
+
+	Parser parser = parserBuilder.initGrammarLexer().loadGrammar(exprGrammar).build();
+
+	StringSource src("5/2+10*5-4^2");
+	LexerBuilder builder;
+	Lexer lexerTest = builder.withDefaultStates().withStandardOperators().build();
+	TestValueStack valueStack;
+	LexerResultInfo resultInfo;
+
+	while (ParseStatus_ok == parser.parseNext({
+		.lexer = lexerTest,
+		.source = src,
+		.lexerResInfo = resultInfo,
+		.valueStack = valueStack,
+		.startState = 0,
+	})) {
+
+	}
+
+    EXPECT_EQ(36.5, valueStack.getTop());
+}
+
+TEST(Parser, MoveTest) {
+	auto run = [](Parser& parser) {
+		StringSource src("1+2");
+		Lexer lexerTest = LexerBuilder().withDefaultStates().withStandardOperators().build();
+		TestValueStack valueStack;
+		LexerResultInfo resultInfo;
+
+		parser.reset();
+		int status = ParseStatus_ok;
+		while (ParseStatus_ok == (status = parser.parseNext({
+			.lexer = lexerTest,
+			.source = src,
+			.lexerResInfo = resultInfo,
+			.valueStack = valueStack,
+			.startState = 0,
+		})));
+		return status;
+	};
+
+	ParserBuilder parserBuilder;
+	Parser first = parserBuilder.initGrammarLexer().loadGrammar(exprGrammar).build();
+	Parser second = parserBuilder.build();
+	ASSERT_TRUE(second.getTables());
+	EXPECT_EQ(ParseStatus_finish, run(first));
+	EXPECT_EQ(ParseStatus_err, run(second));
+
+	Parser moved = std::move(first);
+	ASSERT_TRUE(first.getTables());
+	EXPECT_EQ(ParseStatus_err, run(first));
+
+	first = std::move(moved);
+	ASSERT_TRUE(moved.getTables());
+	EXPECT_EQ(ParseStatus_finish, run(first));
+	EXPECT_EQ(ParseStatus_err, run(moved));
+}
+
+TEST(Parser, UnitEliminationTest) {
+	auto run = [&](int flags, size_t& steps) {
+		ParserBuilder parserBuilder;
+		Parser parser = parserBuilder.initGrammarLexer().withFlags(flags).loadGrammar(exprGrammar).build();
+
+		StringSource src("5/2+10*5-4^2");
+		Lexer lexerTest = LexerBuilder().withDefaultStates().withStandardOperators().build();
+		TestValueStack valueStack;
+		LexerResultInfo resultInfo;
+
+		steps = 0;
+		int status = ParseStatus_ok;
+		while (ParseStatus_ok == (status = parser.parseNext({
+			.lexer = lexerTest,
+			.source = src,
+			.lexerResInfo = resultInfo,
+			.valueStack = valueStack,
+			.startState = 0,
+		}))) {
+			++steps;
+		}
+
+		EXPECT_EQ(ParseStatus_finish, status);
+		return valueStack.getTop();
+	};
+
+	size_t plainSteps = 0;
+	size_t optimizedSteps = 0;
+	EXPECT_EQ(36.5, run(ParserBuildFlags_none, plainSteps));
+	EXPECT_EQ(36.5, run(ParserBuildFlags_unitElimination | ParserBuildFlags_defaultReductions, optimizedSteps));
+	EXPECT_LT(optimizedSteps, plainSteps);
+}
+
+TEST(Parser, CompressedTablesTest) {
+	auto run = [&](int flags, const char* text, int& status) {
+		ParserBuilder parserBuilder;
+		Parser parser = parserBuilder.initGrammarLexer().withFlags(flags).loadGrammar(exprGrammar).build();
+
+		const TableStats& stats = parserBuilder.getTableStats();
+		if (flags & ParserBuildFlags_compressTables) {
+			EXPECT_TRUE(parser.getTables()->compressed);
+			EXPECT_LT(stats.bytesAfter, stats.bytesBefore);
+		}
+
+		StringSource src(text);
+		Lexer lexerTest = LexerBuilder().withDefaultStates().withStandardOperators().build();
+		TestValueStack valueStack;
+		LexerResultInfo resultInfo;
+
+		while (ParseStatus_ok == (status = parser.parseNext({
+			.lexer = lexerTest,
+			.source = src,
+			.lexerResInfo = resultInfo,
+			.valueStack = valueStack,
+			.startState = 0,
+		})));
+
+		return status == ParseStatus_finish ? valueStack.getTop() : 0.0;
+	};
+
+	int status = ParseStatus_ok;
+	EXPECT_EQ(36.5, run(ParserBuildFlags_compressTables, "5/2+10*5-4^2", status));
+	EXPECT_EQ(ParseStatus_finish, status);
+	EXPECT_EQ(36.5, run(ParserBuildFlags_compressTables | ParserBuildFlags_unitElimination, "5/2+10*5-4^2", status));
+	EXPECT_EQ(ParseStatus_finish, status);
+
+	run(ParserBuildFlags_compressTables, "5/2+*5", status);
+	EXPECT_EQ(ParseStatus_err, status);
+	run(ParserBuildFlags_compressTables, "5 5", status);
+	EXPECT_EQ(ParseStatus_err, status);
+}
+
+TEST(Parser, ProfileTest) {
+	const char* corpus[] = { "1+2+3+4+5+6", "7*8+9", "10-11+12/4", "2^3+1" };
+
+	auto run = [&](Parser& parser, TransitionProfile* profile, const char* text) {
+		StringSource src(text);
+		Lexer lexerTest = LexerBuilder().withDefaultStates().withStandardOperators().build();
+		TestValueStack valueStack;
+		LexerResultInfo resultInfo;
+
+		parser.reset();
+		parser.setProfile(profile);
+		int status = ParseStatus_ok;
+		while (ParseStatus_ok == (status = parser.parseNext({
+			.lexer = lexerTest,
+			.source = src,
+			.lexerResInfo = resultInfo,
+			.valueStack = valueStack,
+			.startState = 0,
+		})));
+		parser.setProfile(nullptr);
+
+		return status == ParseStatus_finish ? valueStack.getTop() : -1.0;
+	};
+
+	ParserBuilder parserBuilder;
+	parserBuilder.initGrammarLexer().withFlags(ParserBuildFlags_compressTables);
+	Parser plain = parserBuilder.loadGrammar(exprGrammar).build();
+
+	TransitionProfile profile;
+	for (const char* text : corpus) {
+		run(plain, &profile, text);
+	}
+	EXPECT_GT(profile.symbols.get(token_integer), profile.symbols.get(token_minus));
+
+	Parser tuned = parserBuilder.withProfile(&profile).loadGrammar(exprGrammar).build();
+	const CompressedTables& compressed = *tuned.getTables()->compressed;
+	EXPECT_LT(compressed.terminalColumn(token_integer), compressed.terminalColumn(token_circ));
+
+	TransitionProfile tunedProfile;
+	for (const char* text : corpus) {
+		EXPECT_EQ(run(plain, nullptr, text), run(tuned, &tunedProfile, text));
+	}
+	EXPECT_EQ(-1.0, run(tuned, nullptr, "5/2+*5"));
+
+	for (ParserState state = 2; state < 32; ++state) {
+		EXPECT_LE(tunedProfile.states.get(state), tunedProfile.states.get(state - 1));
+	}
+}
+
+class CountingResource : public std::pmr::memory_resource {
+public:
+	CountingResource(std::pmr::memory_resource* upstream) : mUpstream(upstream) { }
+
+	size_t allocations{};
+protected:
+	void* do_allocate(size_t bytes, size_t alignment) override {
+		++allocations;
+		return mUpstream->allocate(bytes, alignment);
+	}
+
+	void do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+		mUpstream->deallocate(ptr, bytes, alignment);
+	}
+
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+		return this == &other;
+	}
+private:
+	std::pmr::memory_resource* mUpstream;
+};
+
+TEST(Parser, MemoryResourceTest) {
+	std::pmr::monotonic_buffer_resource arena;
+	CountingResource builderResource(&arena);
+	Parser parser;
+	{
+		ParserBuilder parserBuilder;
+		parser = parserBuilder.initGrammarLexer().withMemoryResource(&builderResource).loadGrammar(exprGrammar).build();
+	}
+	EXPECT_GT(builderResource.allocations, 0u);
+	arena.release();
+
+	std::pmr::unsynchronized_pool_resource pool;
+	CountingResource lexerResource(&pool);
+	CountingResource parseResource(&pool);
+	Lexer lexerTest = LexerBuilder(&lexerResource).withDefaultStates().withStandardOperators().build();
+	EXPECT_EQ(&lexerResource, lexerTest.getMemoryResource());
+	EXPECT_GT(lexerResource.allocations, 0u);
+
+	Parser local(parser, &parseResource);
+	StringSource src("5/2+10*5-4^2");
+	TestValueStack valueStack;
+	LexerResultInfo resultInfo;
+
+	int status = ParseStatus_ok;
+	while (ParseStatus_ok == (status = local.parseNext({
+		.lexer = lexerTest,
+		.source = src,
+		.lexerResInfo = resultInfo,
+		.valueStack = valueStack,
+		.startState = 0,
+	})));
+
+	EXPECT_EQ(ParseStatus_finish, status);
+	EXPECT_EQ(36.5, valueStack.getTop());
+	EXPECT_GT(parseResource.allocations, 0u);
+}
+
+TEST(Parser, LazyTablesTest) {
+	Parser parser = ParserBuilder().initGrammarLexer().withFlags(ParserBuildFlags_lazyTables).loadGrammar(exprGrammar).build();
+	const std::shared_ptr<LazyTables>& lazy = parser.getTables()->lazy;
+	ASSERT_TRUE(lazy);
+	EXPECT_EQ(0, lazy->materializedStates());
+
+	auto run = [](Parser parser, const char* text) {
+		StringSource src(text);
+		Lexer lexerTest = LexerBuilder().withDefaultStates().withStandardOperators().build();
+		TestValueStack valueStack;
+		LexerResultInfo resultInfo;
+
+		int status = ParseStatus_ok;
+		while (ParseStatus_ok == (status = parser.parseNext({
+			.lexer = lexerTest,
+			.source = src,
+			.lexerResInfo = resultInfo,
+			.valueStack = valueStack,
+			.startState = 0,
+		})));
+
+		return status == ParseStatus_finish ? valueStack.getTop() : -1.0;
+	};
+
+	EXPECT_EQ(7, run(parser, "3+4"));
+	size_t touched = lazy->materializedStates();
+	EXPECT_GT(touched, 0);
+
+	std::vector<std::thread> threads;
+	std::vector<double> results(4);
+	for (size_t i = 0; i < results.size(); ++i) {
+		threads.emplace_back([&, i] {
+			results[i] = run(parser, "5/2+10*5-4^2");
+		});
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	for (double result : results) {
+		EXPECT_EQ(36.5, result);
+	}
+	EXPECT_GT(lazy->materializedStates(), touched);
+	EXPECT_EQ(-1.0, run(parser, "5/2+*5"));
+}
+
+TEST(Parser, FirstSetsTest) {
     const StrRule grammar[] = {
 		{ "S -> E" },
-		{ "E -> E + T", RuleOpTags_plus },
-		{ "E -> E - T", RuleOpTags_minus }, 
-		{ "E -> T" },
-		{ "T -> T * P", RuleOpTags_mul },
-		{ "T -> T / P", RuleOpTags_div },
-		{ "T -> P" },
-		{ "P -> F ^ P", RuleOpTags_pow },
-		{ "P -> F" },
+		{ "E -> T P" },
+		{ "P -> + T P" },
+		{ "P -> " },
+		{ "T -> F" },
 		{ "F -> int" },
 		{ "F -> real" }
 	};
 
 	ParserBuilder parserBuilder;
-
 	Parser parser = parserBuilder.initGrammarLexer().loadGrammar(grammar).build();
+	const FirstSets& firstSets = parserBuilder.getFirstSets();
 
-	StringSource src("5/2+10*5-4^2");
-	LexerBuilder builder;
-	Lexer lexerTest = builder.withDefaultStates().withStandardOperators().build();
+	auto firstOf = [&](TokenID id) {
+		std::set<TokenID> terminals;
+		firstSets.forEachTerminal(firstSets.first(firstSets.nonterminalIndex(id)), [&](TokenID terminal) {
+			terminals.insert(terminal);
+		});
+		return terminals;
+	};
+
+	std::set<TokenID> operands { token_integer, token_real };
+	EXPECT_EQ(operands, firstOf(ParserStates_stmt));
+	EXPECT_EQ(operands, firstOf(ParserStates_expr));
+	EXPECT_EQ(1u, firstOf(ParserStates_pow).size());
+	EXPECT_TRUE(firstSets.nullable(firstSets.nonterminalIndex(ParserStates_pow)));
+	EXPECT_FALSE(firstSets.nullable(firstSets.nonterminalIndex(ParserStates_expr)));
+
+	StringSource src("1+2+3");
+	Lexer lexerTest = LexerBuilder().withDefaultStates().withStandardOperators().build();
 	TestValueStack valueStack;
 	LexerResultInfo resultInfo;
 
-	while (ParseStatus_ok == parser.parseNext({
+	int status = ParseStatus_ok;
+	while (ParseStatus_ok == (status = parser.parseNext({
+		.lexer = lexerTest,
+		.source = src,
+		.lexerResInfo = resultInfo,
+		.valueStack = valueStack,
+		.startState = 0,
+	})));
+	EXPECT_EQ(ParseStatus_finish, status);
+}
+
+TEST(Parser, PrecedenceTest) {
+    const StrRule flat[] = {
+		{ "S -> E" },
+		{ "E -> E + E", RuleOpTags_plus },
+		{ "E -> E - E", RuleOpTags_minus }, 
+		{ "E -> E * E", RuleOpTags_mul },
+		{ "E -> E / E", RuleOpTags_div },
+		{ "E -> E ^ E", RuleOpTags_pow },
+		{ "E -> int" },
+		{ "E -> real" }
+	};
+
+	auto run = [&](std::span<const StrRule> grammar, const char* text, size_t& steps, size_t& states) {
+		ParserBuilder parserBuilder;
+		parserBuilder.initGrammarLexer()
+			.addPrecedence(PrecAssoc_left, { token_plus, token_minus })
+			.addPrecedence(PrecAssoc_left, { token_mul, token_div })
+			.addPrecedence(PrecAssoc_right, { token_circ });
+		Parser parser = parserBuilder.loadGrammar(grammar).build();
+		EXPECT_EQ(0u, parserBuilder.getTableStats().conflicts);
+		states = parser.getTables()->actionTable.size();
+
+		StringSource src(text);
+		Lexer lexerTest = LexerBuilder().withDefaultStates().withStandardOperators().build();
+		TestValueStack valueStack;
+		LexerResultInfo resultInfo;
+
+		steps = 0;
+		int status = ParseStatus_ok;
+		while (ParseStatus_ok == (status = parser.parseNext({
+			.lexer = lexerTest,
+			.source = src,
+			.lexerResInfo = resultInfo,
+			.valueStack = valueStack,
+			.startState = 0,
+		}))) {
+			++steps;
+		}
+
+		EXPECT_EQ(ParseStatus_finish, status);
+		return valueStack.getTop();
+	};
+
+	size_t layeredSteps = 0, layeredStates = 0;
+	size_t flatSteps = 0, flatStates = 0;
+	EXPECT_EQ(36.5, run(exprGrammar, "5/2+10*5-4^2^1", layeredSteps, layeredStates));
+	EXPECT_EQ(36.5, run(flat, "5/2+10*5-4^2^1", flatSteps, flatStates));
+	EXPECT_LT(flatSteps, layeredSteps);
+	EXPECT_LT(flatStates, layeredStates);
+
+	// ^ groups to the right, - to the left.
+	EXPECT_EQ(512, run(flat, "2^3^2", flatSteps, flatStates));
+	EXPECT_EQ(1, run(flat, "10-4-5", flatSteps, flatStates));
+}
+
+TEST(Parser, TypedValueStackTest) {
+	ParserBuilder parserBuilder;
+	Parser parser = parserBuilder.initGrammarLexer().loadGrammar(exprGrammar).build();
+
+	StringSource src("5/2+10*5-4^2");
+	Lexer lexerTest = LexerBuilder().withDefaultStates().withStandardOperators().build();
+	LexerResultInfo resultInfo;
+
+	TypedValueStack<double> valueStack = makeExprEvaluator();
+
+	while (ParseStatus_ok == parser.parseNext<TypedValueStack<double>>({
 		.lexer = lexerTest,
 		.source = src,
 		.lexerResInfo = resultInfo,
@@ -110,5 +478,6 @@ TEST(Parser, ExprTest) {
 
 	}
 
-    EXPECT_EQ(36.5, valueStack.getTop());
+	EXPECT_EQ(1u, valueStack.size());
+	EXPECT_EQ(36.5, valueStack.top());
 }
\ No newline at end of file
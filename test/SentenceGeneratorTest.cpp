@@ -0,0 +1,64 @@
+#include "ExprGrammar.hpp"
+#include "LexerSources.hpp"
+#include <gtest/gtest.h>
+#include <LexerBuilder.hpp>
+#include <SentenceGenerator.hpp>
+#include <TypedValueStack.hpp>
+#include <sstream>
+
+TEST(SentenceGenerator, ExprTest) {
+	std::istringstream grammar(R"(
+		stmts -> stmts stmt | stmt
+		stmt -> let id ':' expr ';' | print expr ';'
+		expr -> expr '+' term | expr '-' term | term
+		term -> term '*' fact | fact
+		fact -> int | real | id | '(' expr ')'
+	)");
+
+	ParserBuilder parserBuilder;
+	Parser parser = parserBuilder.loadGrammarStream(grammar).build();
+	ASSERT_EQ(TKN_OK, parserBuilder.getLoadInfo().status) << parserBuilder.getLoadInfo().message;
+
+	LexerBuilder lexerBuilder;
+	parserBuilder.getSymbols().addTerminals(lexerBuilder.withDefaultStates().withStandardOperators());
+	Lexer lexer = lexerBuilder.build();
+	TypedValueStack<int> valueStack;
+
+	for (size_t targetSize : { 16, 1 << 10, 1 << 14 }) {
+		for (uint64_t seed = 0; seed < 8; ++seed) {
+			SentenceGenerator generator(parserBuilder.getGrammar(), { .seed = seed, .targetSize = targetSize });
+			std::ostringstream text;
+			size_t size = generator.write(text);
+			EXPECT_EQ(size, text.str().size());
+			EXPECT_GE(size + 64, targetSize);
+			EXPECT_LE(size, targetSize + 256);
+
+			StringSource src(text.str());
+			EXPECT_EQ(ParseStatus_finish, parseAll(parser, lexer, src, valueStack)) << text.str();
+
+			// The same seed streams the same sentence straight into the parser.
+			SentenceGenerator again(parserBuilder.getGrammar(), { .seed = seed, .targetSize = targetSize });
+			SentenceSource stream(again);
+			EXPECT_EQ(ParseStatus_finish, parseAll(parser, lexer, stream, valueStack));
+			EXPECT_EQ(size, again.emitted());
+		}
+	}
+
+	SentenceGenerator shallow(parserBuilder.getGrammar(), { .targetSize = 1 << 20, .maxDepth = 6 });
+	std::ostringstream text;
+	EXPECT_LT(shallow.write(text), 1u << 12);
+
+	std::ostringstream corpus;
+	SentenceGenerator lines(parserBuilder.getGrammar(), { .seed = 1, .targetSize = 256 });
+	EXPECT_GE(lines.writeCorpus(corpus, 1 << 14), 1u << 14);
+
+	std::istringstream corpusLines(corpus.str());
+	std::string line;
+	size_t lineCount = 0;
+	while (std::getline(corpusLines, line)) {
+		StringSource src(line);
+		EXPECT_EQ(ParseStatus_finish, parseAll(parser, lexer, src, valueStack)) << line;
+		++lineCount;
+	}
+	EXPECT_GT(lineCount, 16u);
+}
@@ -0,0 +1,90 @@
+#include "ExprGrammar.hpp"
+#include "LexerSources.hpp"
+#include <gtest/gtest.h>
+#include <LexerBuilder.hpp>
+#include <ParserBuilder.hpp>
+#include <SyntaxTree.hpp>
+#include <string>
+
+static double evalNode(const SyntaxTree& tree, const SyntaxNode& node) {
+	if (node.isLeaf()) {
+		return std::stod(std::string(tree.text(node)));
+	}
+
+	auto children = tree.children(node);
+	if (children.size() == 1) {
+		return evalNode(tree, children[0]);
+	}
+
+	return applyRuleOp(node.tag, evalNode(tree, children[0]), evalNode(tree, children[2]));
+}
+
+TEST(SyntaxTree, ExprTest) {
+	ParserBuilder parserBuilder;
+	Parser parser = parserBuilder.initGrammarLexer().loadGrammar(exprGrammar).build();
+
+	StringSource src("5/2+10*5-4^2");
+	Lexer lexerTest = LexerBuilder().withDefaultStates().withStandardOperators().build();
+	LexerResultInfo resultInfo;
+	SyntaxTree tree;
+
+	while (ParseStatus_ok == parser.parseNext<SyntaxTree>({
+		.lexer = lexerTest,
+		.source = src,
+		.lexerResInfo = resultInfo,
+		.valueStack = tree,
+		.startState = 0,
+	})) {
+
+	}
+
+	ASSERT_TRUE(tree.finish());
+	ASSERT_NE(nullptr, tree.root());
+	EXPECT_EQ(RuleOpTags_minus, tree.root()->tag);
+	EXPECT_EQ(11u, tree.tokens().size());
+	EXPECT_EQ(36.5, evalNode(tree, *tree.root()));
+
+	tree.compact();
+	EXPECT_EQ(0u, tree.root()->tokenOffset);
+	EXPECT_EQ(36.5, evalNode(tree, *tree.root()));
+
+	tree.clear();
+	EXPECT_EQ(nullptr, tree.root());
+	EXPECT_TRUE(tree.nodes().empty());
+}
+
+TEST(SyntaxTree, EpsilonTest) {
+    const StrRule grammar[] = {
+		{ "S -> E" },
+		{ "E -> T P" },
+		{ "P -> + T P" },
+		{ "P -> " },
+		{ "T -> int" }
+	};
+
+	Parser parser = ParserBuilder().initGrammarLexer().loadGrammar(grammar).build();
+	StringSource src("1+2");
+	Lexer lexerTest = LexerBuilder().withDefaultStates().withStandardOperators().build();
+	LexerResultInfo resultInfo;
+	SyntaxTree tree;
+
+	while (ParseStatus_ok == parser.parseNext<SyntaxTree>({
+		.lexer = lexerTest,
+		.source = src,
+		.lexerResInfo = resultInfo,
+		.valueStack = tree,
+		.startState = 0,
+	}));
+	ASSERT_TRUE(tree.finish());
+
+	// The trailing P derives nothing and sits past the last token.
+	size_t epsilons = 0;
+	for (const SyntaxNode& node : tree.nodes()) {
+		if (!node.isLeaf() && node.childCount == 0) {
+			EXPECT_EQ(nullptr, tree.token(node).info);
+			EXPECT_TRUE(tree.text(node).empty());
+			++epsilons;
+		}
+	}
+	EXPECT_EQ(1u, epsilons);
+}
@@ -0,0 +1,69 @@
+#include "ExprGrammar.hpp"
+#include <gtest/gtest.h>
+#include <LexerBuilder.hpp>
+#include <Tracer.hpp>
+#include <set>
+#include <sstream>
+#include <thread>
+
+static size_t countOf(const std::string& text, const std::string& needle) {
+	size_t count = 0;
+	for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) {
+		++count;
+	}
+	return count;
+}
+
+TEST(Tracer, TimelineTest) {
+	ParserBuilder parserBuilder;
+	Parser untraced = parserBuilder.initGrammarLexer().loadGrammar(exprGrammar).build();
+	EXPECT_EQ(0u, Tracer::eventCount());
+
+	TraceOptions options;
+	options.sampling[TraceSample_token] = 2;
+	options.sampling[TraceSample_reduce] = 1;
+	Tracer::start(options);
+
+	Parser parser = parserBuilder.loadGrammar(exprGrammar).build();
+	Lexer lexer = LexerBuilder().withDefaultStates().withStandardOperators().build();
+
+	auto parse = [&] {
+		Parser local = parser;
+		TypedValueStack<int> valueStack;
+		TraceScope trace("parse", "test");
+		parseAll(local, lexer, "1 + 2 * 3 + 4", valueStack);
+	};
+
+	std::thread first(parse);
+	first.join();
+	std::thread second(parse);
+	second.join();
+	Tracer::stop();
+
+	std::ostringstream out;
+	Tracer::writeJson(out);
+	std::string json = out.str();
+
+	EXPECT_EQ(1u, countOf(json, "\"name\":\"buildTables\""));
+	EXPECT_EQ(1u, countOf(json, "\"name\":\"computeFirstSets\""));
+	EXPECT_EQ(0u, countOf(json, "\"name\":\"computeClosure\""));
+	EXPECT_EQ(2u, countOf(json, "\"name\":\"parse\""));
+
+	// Seven shifts per parse, every second one kept; every reduce kept.
+	EXPECT_EQ(6u, countOf(json, "\"name\":\"shift\""));
+	EXPECT_EQ(2u * 15, countOf(json, "\"name\":\"reduce\""));
+
+	std::set<std::string> parseTracks;
+	for (size_t pos = json.find("\"name\":\"parse\""); pos != std::string::npos; pos = json.find("\"name\":\"parse\"", pos + 1)) {
+		size_t tid = json.find("\"tid\":", pos);
+		parseTracks.insert(json.substr(tid, json.find(',', tid) - tid));
+	}
+	EXPECT_EQ(2u, parseTracks.size());
+
+	size_t events = Tracer::eventCount();
+	parse();
+	EXPECT_EQ(events, Tracer::eventCount());
+
+	Tracer::clear();
+	EXPECT_EQ(0u, Tracer::eventCount());
+}